@@ -138,6 +138,293 @@ void main() {
     });
   });
 
+  group('Branching Strategies', () {
+    test('Every strategy finds the same solution', () {
+      final puzzle = SudokuNative.generate(n: 3, seed: 4242, difficulty: 1.0)!;
+      final expected = List<int>.from(puzzle);
+      expect(SudokuNative.solve(expected, 3), 1);
+
+      for (final order in [0, SudokuNative.orderLcv]) {
+        for (final heuristic in [
+          SudokuNative.strategyMrv,
+          SudokuNative.strategyMrvFail,
+          SudokuNative.strategyDomWdeg,
+          SudokuNative.strategyMrvRandom,
+        ]) {
+          final table = List<int>.from(puzzle);
+          final stats = SudokuNative.solveWithStrategy(table, 3, heuristic | order, seed: 7);
+          expect(stats['result'], 1);
+          expect(stats['strategy'], heuristic | order);
+          expect(stats['forwards'], greaterThan(0));
+          expect(table, expected);
+        }
+      }
+    });
+
+    test('Conflict learning agrees with the default search', () {
+      for (final n in [2, 3, 4]) {
+        final puzzle = SudokuNative.generate(
+            n: n, seed: 31, difficulty: n == 4 ? 0.5 : 1.0, timeoutMs: 10000)!;
+        final expected = List<int>.from(puzzle);
+        expect(SudokuNative.solve(expected, n), 1);
+
+        for (final seed in [1, 2, 3]) {
+          final table = List<int>.from(puzzle);
+          final stats = SudokuNative.solveWithStrategy(
+              table, n, SudokuNative.strategyMrvFail | SudokuNative.searchLearn, seed: seed);
+          expect(stats['result'], 1);
+          expect(stats['strategy'], SudokuNative.strategyMrvFail | SudokuNative.searchLearn);
+          expect(table, expected);
+        }
+      }
+
+      final empty = List<int>.filled(81, 0);
+      expect(SudokuNative.solveWithStrategy(empty, 3, SudokuNative.searchLearn)['result'], 2);
+      final conflict = List<int>.filled(81, 0);
+      conflict[0] = 5;
+      conflict[1] = 5;
+      expect(SudokuNative.solveWithStrategy(conflict, 3, SudokuNative.searchLearn)['result'], 0);
+    });
+
+    test('Unknown strategies fall back to the default', () {
+      final puzzle = SudokuNative.generate(n: 2, seed: 5, difficulty: 1.0)!;
+      final stats = SudokuNative.solveWithStrategy(puzzle, 2, 0x7f);
+      expect(stats['result'], 1);
+      expect(stats['strategy'], SudokuNative.strategyMrvFail);
+    });
+  });
+
+  group('Portfolio Solving', () {
+    test('Portfolio finds the same solution as a single solve', () {
+      for (final n in [3, 4]) {
+        final puzzle = SudokuNative.generate(
+            n: n, seed: 2024, difficulty: n == 3 ? 1.0 : 0.5, timeoutMs: 10000)!;
+        final expected = List<int>.from(puzzle);
+        expect(SudokuNative.solve(expected, n), 1);
+
+        final table = List<int>.from(puzzle);
+        expect(SudokuNative.solvePortfolio(table, n, threads: 4, seed: 9), 1);
+        expect(table, expected);
+      }
+    });
+
+    test('Portfolio reports multiple solutions and conflicts', () {
+      final empty = List<int>.filled(81, 0);
+      expect(SudokuNative.solvePortfolio(empty, 3, threads: 3), 2);
+
+      final conflict = List<int>.filled(81, 0);
+      conflict[0] = 5;
+      conflict[1] = 5;
+      expect(SudokuNative.solvePortfolio(conflict, 3, threads: 3), 0);
+    });
+  });
+
+  group('Batch Validation', () {
+    test('Classifies solved, incomplete and conflicting boards', () {
+      final boards = <List<int>>[];
+      final expected = <int>[];
+      for (int seed = 1; seed <= 20; seed++) {
+        final puzzle = SudokuNative.generate(n: 3, seed: seed, difficulty: 1.0)!;
+        final solved = List<int>.from(puzzle);
+        expect(SudokuNative.solve(solved, 3), 1);
+
+        boards.add(puzzle);
+        expected.add(2);
+        boards.add(solved);
+        expected.add(1);
+
+        // Swapping two cells of a row keeps the row valid but breaks a column
+        final broken = List<int>.from(solved);
+        final tmp = broken[0];
+        broken[0] = broken[4];
+        broken[4] = tmp;
+        boards.add(broken);
+        expected.add(0);
+      }
+
+      expect(SudokuNative.validateBatch(boards, 3), expected);
+    });
+
+    test('Out of range values are conflicts', () {
+      final board = List<int>.filled(16, 0);
+      board[5] = 5;
+      expect(SudokuNative.validateBatch([board], 2), [0]);
+    });
+  });
+
+  group('Batch Solving', () {
+    test('Matches one-by-one solving for 4x4 and 9x9', () {
+      for (final n in [2, 3]) {
+        final ne4 = n * n * n * n;
+        final boards = <List<int>>[];
+        for (int seed = 1; seed <= 40; seed++) {
+          final puzzle = SudokuNative.generate(n: n, seed: seed, difficulty: 1.0)!;
+          if (seed % 4 == 1) {
+            // drop every third clue: usually several solutions
+            for (int i = 0; i < ne4; i += 3) {
+              puzzle[i] = 0;
+            }
+          } else if (seed % 4 == 2) {
+            final i = puzzle.indexOf(0);
+            puzzle[i] = puzzle.firstWhere((v) => v != 0);
+          }
+          boards.add(puzzle);
+        }
+        boards.add(List<int>.filled(ne4, 0));
+
+        final expected = boards.map((b) => List<int>.from(b)).toList();
+        final expectedResults = [for (final b in expected) SudokuNative.solve(b, n)];
+
+        expect(SudokuNative.solveBatch(boards, n), expectedResults);
+        expect(boards, expected);
+        expect(expectedResults, contains(1));
+      }
+    });
+  });
+
+  group('Propagation Session', () {
+    test('Moves propagate and undo restores every earlier state', () {
+      final solution = SudokuNative.generate(n: 3, seed: 99, difficulty: 1.0)!;
+      expect(SudokuNative.solve(solution, 3), 1);
+      // a few givens, so that singles alone do not finish the board
+      final givens = List<int>.filled(81, 0);
+      for (int i = 0; i < 81; i += 9) {
+        givens[i] = solution[i];
+      }
+
+      final session = NativeSession.open(givens, 3)!;
+      try {
+        for (int i = 0; i < 81; i += 9) {
+          expect(session.values[i], solution[i]);
+        }
+        final initialValues = List<int>.from(session.values);
+        final initialCandidates = List<int>.from(session.candidates);
+
+        final history = <List<int>>[];
+        for (int i = 0; i < 81; i++) {
+          if (session.values[i] != 0) continue;
+          history.add(List<int>.from(session.candidates));
+          expect(session.assign(i, solution[i]), true);
+        }
+        expect(history, isNotEmpty);
+        expect(session.values, solution);
+        for (int i = 0; i < 81; i++) {
+          expect(session.candidates[i], 1 << (solution[i] - 1));
+        }
+
+        for (final candidates in history.reversed) {
+          expect(session.undo(), true);
+          expect(session.candidates, candidates);
+        }
+        expect(session.undo(), false);
+        expect(session.values, initialValues);
+        expect(session.candidates, initialCandidates);
+
+        expect(session.redo(), true);
+        expect(session.candidates, isNot(initialCandidates));
+      } finally {
+        session.dispose();
+      }
+    });
+
+    test('Eliminations leave singles and conflicts are reported', () {
+      final session = NativeSession.open(List<int>.filled(16, 0), 2)!;
+      try {
+        expect(session.eliminate(0, 1), true);
+        expect(session.eliminate(0, 2), true);
+        expect(session.eliminate(0, 3), true);
+        expect(session.values[0], 4);
+        // 4 is ruled out for the rest of the row, column and box
+        expect(session.candidates[1] & 8, 0);
+        expect(session.candidates[4] & 8, 0);
+        expect(session.candidates[5] & 8, 0);
+
+        expect(session.assign(1, 4), false);
+        expect(session.conflict, true);
+        expect(session.undo(), true);
+        expect(session.conflict, false);
+        expect(() => session.assign(16, 1), throwsRangeError);
+      } finally {
+        session.dispose();
+      }
+
+      final conflict = List<int>.filled(16, 0);
+      conflict[0] = 1;
+      conflict[1] = 1;
+      expect(NativeSession.open(conflict, 2), isNull);
+    });
+  });
+
+  group('Stepped Solving', () {
+    test('Slices give the same result, solution and effort as one call', () {
+      final puzzles = <List<int>>[
+        SudokuNative.generate(n: 3, seed: 31, difficulty: 1.0)!,
+        SudokuNative.generate(n: 4, seed: 31, difficulty: 0.5, timeoutMs: 10000)!,
+        List<int>.filled(81, 0),
+      ];
+      final conflict = List<int>.filled(81, 0);
+      conflict[0] = 5;
+      conflict[1] = 5;
+      puzzles.add(conflict);
+
+      for (final puzzle in puzzles) {
+        final n = puzzle.length == 81 ? 3 : 4;
+        final expected = List<int>.from(puzzle);
+        final stats = SudokuNative.solveWithStrategy(expected, n, SudokuNative.strategyMrvFail);
+
+        for (final maxNodes in [1, 17, 1 << 20]) {
+          final solve = NativeSolve.begin(puzzle, n);
+          int slices = 0;
+          int result;
+          while ((result = solve.step(maxNodes)) == NativeSolve.running) {
+            slices++;
+          }
+          expect(result, stats['result']);
+          expect(solve.step(maxNodes), result);
+          expect(solve.forwards, stats['forwards']);
+          if (maxNodes == 1 && result != 0) expect(slices, greaterThan(0));
+          final solution = solve.end();
+          expect(solution, result == 1 ? expected : isNull);
+        }
+      }
+    });
+  });
+
+  group('Minimality', () {
+    test('Fully reduced puzzles are minimal; an extra clue is redundant', () {
+      for (final n in [2, 3]) {
+        for (int seed = 1; seed <= 10; seed++) {
+          final puzzle = SudokuNative.generate(n: n, seed: seed, difficulty: 1.0)!;
+          expect(SudokuNative.redundantClues(puzzle, n), isEmpty);
+
+          final solution = List<int>.from(puzzle);
+          expect(SudokuNative.solve(solution, n), 1);
+          final extra = puzzle.indexOf(0);
+          puzzle[extra] = solution[extra];
+          final redundant = SudokuNative.redundantClues(puzzle, n)!;
+          expect(redundant, contains(extra));
+
+          // agrees with removing each clue and re-solving
+          for (int i = 0; i < puzzle.length; i++) {
+            if (puzzle[i] == 0) continue;
+            final reduced = List<int>.from(puzzle);
+            reduced[i] = 0;
+            expect(redundant.contains(i), SudokuNative.solve(reduced, n) == 1);
+          }
+        }
+      }
+    });
+
+    test('Returns null without a unique solution', () {
+      expect(SudokuNative.redundantClues(List<int>.filled(81, 0), 3), isNull);
+
+      final conflict = List<int>.filled(16, 0);
+      conflict[0] = 1;
+      conflict[1] = 1;
+      expect(SudokuNative.redundantClues(conflict, 2), isNull);
+    });
+  });
+
   group('Trivial Puzzle Filtering', () {
     test('trivialAllowed=false returns null for trivially solvable puzzles', () {
       // Some seeds produce trivially solvable puzzles
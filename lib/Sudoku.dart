@@ -277,6 +277,7 @@ class Sudoku {
         difficulty: generatedDifficulty,
         timeoutMs: n == 4 ? 30000 : 10000,
         trivialAllowed: false,
+        pregenerated: true,
       );
 
       if (puzzle != null) {
@@ -1,5 +1,6 @@
 import 'dart:ffi';
 import 'dart:io';
+import 'dart:typed_data';
 
 import 'package:ffi/ffi.dart';
 
@@ -11,6 +12,9 @@ typedef SdGenerateNative = Int32 Function(
 typedef SdGenerate = int Function(
     Pointer<Uint8> outTable, int n, int seed, double difficulty, int timeoutMs);
 
+typedef SdTakePregeneratedNative = Int32 Function(Pointer<Uint8> outTable, Int32 n, Float difficulty);
+typedef SdTakePregenerated = int Function(Pointer<Uint8> outTable, int n, double difficulty);
+
 typedef SdSolveNative = Int32 Function(Pointer<Uint8> table, Int32 n);
 typedef SdSolve = int Function(Pointer<Uint8> table, int n);
 
@@ -37,12 +41,74 @@ typedef SdDifficulty = int Function(
     Pointer<Int32> outMaxBt,
     Pointer<Int32> outAvgBt);
 
+typedef SdSolveStrategyNative = Int32 Function(Pointer<Uint8> table, Int32 n, Int32 strategy,
+    Uint32 seed, Pointer<Int32> outStrategy, Pointer<Int32> outForwards, Pointer<Int32> outBacktracks);
+typedef SdSolveStrategy = int Function(Pointer<Uint8> table, int n, int strategy,
+    int seed, Pointer<Int32> outStrategy, Pointer<Int32> outForwards, Pointer<Int32> outBacktracks);
+
+typedef SdSolvePortfolioNative = Int32 Function(
+    Pointer<Uint8> table, Int32 n, Int32 threads, Uint32 seed, Pointer<Int32> outWinner);
+typedef SdSolvePortfolio = int Function(
+    Pointer<Uint8> table, int n, int threads, int seed, Pointer<Int32> outWinner);
+
+typedef SdValidateBatchNative = Int32 Function(
+    Pointer<Uint8> boards, Int32 n, Int32 count, Pointer<Uint8> outCodes);
+typedef SdValidateBatch = int Function(
+    Pointer<Uint8> boards, int n, int count, Pointer<Uint8> outCodes);
+
+typedef SdSolveBatchNative = Int32 Function(
+    Pointer<Uint8> boards, Int32 n, Int32 count, Pointer<Uint8> outResults);
+typedef SdSolveBatch = int Function(
+    Pointer<Uint8> boards, int n, int count, Pointer<Uint8> outResults);
+
+typedef SdCheckMinimalNative = Int32 Function(Pointer<Uint8> table, Int32 n, Pointer<Uint8> outRedundantMask);
+typedef SdCheckMinimal = int Function(Pointer<Uint8> table, int n, Pointer<Uint8> outRedundantMask);
+
+typedef SdSessionNewNative = Pointer<Void> Function(Pointer<Uint8> table, Int32 n);
+typedef SdSessionNew = Pointer<Void> Function(Pointer<Uint8> table, int n);
+typedef SdSessionMoveNative = Int32 Function(Pointer<Void> session, Int32 cell, Int32 value);
+typedef SdSessionMove = int Function(Pointer<Void> session, int cell, int value);
+typedef SdSessionStepNative = Int32 Function(Pointer<Void> session);
+typedef SdSessionStep = int Function(Pointer<Void> session);
+typedef SdSessionCandidatesNative = Pointer<Uint64> Function(Pointer<Void> session);
+typedef SdSessionValuesNative = Pointer<Uint8> Function(Pointer<Void> session);
+typedef SdSessionFreeNative = Void Function(Pointer<Void> session);
+typedef SdSessionFree = void Function(Pointer<Void> session);
+
+typedef SdSolveBeginNative = Pointer<Void> Function(Pointer<Uint8> table, Int32 n);
+typedef SdSolveBegin = Pointer<Void> Function(Pointer<Uint8> table, int n);
+typedef SdSolveStepNative = Int32 Function(Pointer<Void> handle, Int32 maxNodes);
+typedef SdSolveStep = int Function(Pointer<Void> handle, int maxNodes);
+typedef SdSolveForwardsNative = Int32 Function(Pointer<Void> handle);
+typedef SdSolveForwards = int Function(Pointer<Void> handle);
+typedef SdSolveEndNative = Void Function(Pointer<Void> handle, Pointer<Uint8> outTable);
+typedef SdSolveEnd = void Function(Pointer<Void> handle, Pointer<Uint8> outTable);
+
 /// Native sudoku library wrapper
 class SudokuNative {
   static DynamicLibrary? _lib;
   static SdGenerate? _generate;
+  static SdTakePregenerated? _takePregenerated;
   static SdSolve? _solve;
+  static SdSolveStrategy? _solveStrategy;
+  static SdSolvePortfolio? _solvePortfolio;
   static SdDifficulty? _difficulty;
+  static SdValidateBatch? _validateBatch;
+  static SdSolveBatch? _solveBatch;
+  static SdCheckMinimal? _checkMinimal;
+  static SdSessionNew? _sessionNew;
+  static SdSessionMove? _sessionAssign;
+  static SdSessionMove? _sessionEliminate;
+  static SdSessionStep? _sessionUndo;
+  static SdSessionStep? _sessionRedo;
+  static SdSessionStep? _sessionConflict;
+  static SdSessionCandidatesNative? _sessionCandidates;
+  static SdSessionValuesNative? _sessionValues;
+  static SdSessionFree? _sessionFree;
+  static SdSolveBegin? _solveBegin;
+  static SdSolveStep? _solveStep;
+  static SdSolveForwards? _solveForwards;
+  static SdSolveEnd? _solveEnd;
 
   /// Load the native library
   static void _ensureLoaded() {
@@ -60,8 +126,27 @@ class SudokuNative {
     _lib = DynamicLibrary.open(libName);
 
     _generate = _lib!.lookupFunction<SdGenerateNative, SdGenerate>('sd_generate');
+    _takePregenerated = _lib!.lookupFunction<SdTakePregeneratedNative, SdTakePregenerated>('sd_take_pregenerated');
     _solve = _lib!.lookupFunction<SdSolveNative, SdSolve>('sd_solve');
+    _solveStrategy = _lib!.lookupFunction<SdSolveStrategyNative, SdSolveStrategy>('sd_solve_strategy');
+    _solvePortfolio = _lib!.lookupFunction<SdSolvePortfolioNative, SdSolvePortfolio>('sd_solve_portfolio');
     _difficulty = _lib!.lookupFunction<SdDifficultyNative, SdDifficulty>('sd_difficulty');
+    _validateBatch = _lib!.lookupFunction<SdValidateBatchNative, SdValidateBatch>('sd_validate_batch');
+    _solveBatch = _lib!.lookupFunction<SdSolveBatchNative, SdSolveBatch>('sd_solve_batch');
+    _checkMinimal = _lib!.lookupFunction<SdCheckMinimalNative, SdCheckMinimal>('sd_check_minimal');
+    _sessionNew = _lib!.lookupFunction<SdSessionNewNative, SdSessionNew>('sd_session_new');
+    _sessionAssign = _lib!.lookupFunction<SdSessionMoveNative, SdSessionMove>('sd_session_assign');
+    _sessionEliminate = _lib!.lookupFunction<SdSessionMoveNative, SdSessionMove>('sd_session_eliminate');
+    _sessionUndo = _lib!.lookupFunction<SdSessionStepNative, SdSessionStep>('sd_session_undo');
+    _sessionRedo = _lib!.lookupFunction<SdSessionStepNative, SdSessionStep>('sd_session_redo');
+    _sessionConflict = _lib!.lookupFunction<SdSessionStepNative, SdSessionStep>('sd_session_conflict');
+    _sessionCandidates = _lib!.lookupFunction<SdSessionCandidatesNative, SdSessionCandidatesNative>('sd_session_candidates');
+    _sessionValues = _lib!.lookupFunction<SdSessionValuesNative, SdSessionValuesNative>('sd_session_values');
+    _sessionFree = _lib!.lookupFunction<SdSessionFreeNative, SdSessionFree>('sd_session_free');
+    _solveBegin = _lib!.lookupFunction<SdSolveBeginNative, SdSolveBegin>('sd_solve_begin');
+    _solveStep = _lib!.lookupFunction<SdSolveStepNative, SdSolveStep>('sd_solve_step');
+    _solveForwards = _lib!.lookupFunction<SdSolveForwardsNative, SdSolveForwards>('sd_solve_forwards');
+    _solveEnd = _lib!.lookupFunction<SdSolveEndNative, SdSolveEnd>('sd_solve_end');
   }
 
   /// Generate a new puzzle
@@ -71,6 +156,8 @@ class SudokuNative {
   /// [difficulty] - 0.0 = easy (many hints), 1.0 = hard (fully reduced)
   /// [timeoutMs] - timeout in milliseconds (0 = no limit)
   /// [trivialAllowed] - if false and puzzle is solvable with basic techniques, returns null
+  /// [pregenerated] - if true, return the puzzle the startup warmup generated
+  ///   for this level when there is one, ignoring [seed]
   ///
   /// Returns the puzzle as a flat list of integers (0 = empty), or null if
   /// trivialAllowed is false and the puzzle is trivially solvable.
@@ -80,6 +167,7 @@ class SudokuNative {
     double difficulty = 1.0,
     int timeoutMs = 5000,
     bool trivialAllowed = true,
+    bool pregenerated = false,
   }) {
     _ensureLoaded();
 
@@ -87,7 +175,9 @@ class SudokuNative {
     final tablePtr = calloc<Uint8>(ne4);
 
     try {
-      _generate!(tablePtr, n, seed, difficulty, timeoutMs);
+      if (!pregenerated || _takePregenerated!(tablePtr, n, difficulty) == 0) {
+        _generate!(tablePtr, n, seed, difficulty, timeoutMs);
+      }
       final puzzle = tablePtr.asTypedList(ne4).toList();
 
       // Check if puzzle is trivially solvable when not allowed
@@ -133,6 +223,189 @@ class SudokuNative {
     }
   }
 
+  /// Branching strategies for [solveWithStrategy]
+  static const int strategyMrv = 0;
+  static const int strategyMrvFail = 1; // default used by [solve]
+  static const int strategyDomWdeg = 2;
+  static const int strategyMrvRandom = 3;
+  /// Or'ed into a strategy: try values least-constraining first
+  static const int orderLcv = 0x100;
+  /// Or'ed into a strategy: backjump and learn nogoods; pays off on hard
+  /// 25x25 puzzles, and replaces [orderLcv] with slot order
+  static const int searchLearn = 0x200;
+
+  /// Solve a puzzle in-place with a chosen branching strategy
+  ///
+  /// [seed] - tie-breaking seed for [strategyMrvRandom]
+  ///
+  /// Returns a map with 'result' (as for [solve]), 'strategy' (the one used),
+  /// 'forwards' and 'backtracks'
+  static Map<String, int> solveWithStrategy(List<int> table, int n, int strategy, {int seed = 1}) {
+    _ensureLoaded();
+
+    final ne4 = n * n * n * n;
+    if (table.length != ne4) {
+      throw ArgumentError('Table length must be $ne4 for n=$n');
+    }
+
+    final tablePtr = calloc<Uint8>(ne4);
+    final strategyPtr = calloc<Int32>(1);
+    final forwardsPtr = calloc<Int32>(1);
+    final backtracksPtr = calloc<Int32>(1);
+    try {
+      tablePtr.asTypedList(ne4).setAll(0, table);
+
+      final result = _solveStrategy!(tablePtr, n, strategy, seed, strategyPtr, forwardsPtr, backtracksPtr);
+
+      if (result == 1) {
+        table.setAll(0, tablePtr.asTypedList(ne4));
+      }
+
+      return {
+        'result': result,
+        'strategy': strategyPtr.value,
+        'forwards': forwardsPtr.value,
+        'backtracks': backtracksPtr.value,
+      };
+    } finally {
+      calloc.free(tablePtr);
+      calloc.free(strategyPtr);
+      calloc.free(forwardsPtr);
+      calloc.free(backtracksPtr);
+    }
+  }
+
+  /// Solve a puzzle in-place by racing [threads] solvers (0 = one per core)
+  /// on differently transformed copies, returning the first answer
+  ///
+  /// Worthwhile for latency-critical solves of large boards; for 9x9 the
+  /// thread start-up outweighs the search.
+  ///
+  /// Returns: 0 = INVALID, 1 = COMPLETE, 2 = MULTIPLE
+  static int solvePortfolio(List<int> table, int n, {int threads = 0, int seed = 1}) {
+    _ensureLoaded();
+
+    final ne4 = n * n * n * n;
+    if (table.length != ne4) {
+      throw ArgumentError('Table length must be $ne4 for n=$n');
+    }
+
+    final tablePtr = calloc<Uint8>(ne4);
+    final winnerPtr = calloc<Int32>(1);
+    try {
+      tablePtr.asTypedList(ne4).setAll(0, table);
+
+      final result = _solvePortfolio!(tablePtr, n, threads, seed, winnerPtr);
+
+      if (result == 1) {
+        table.setAll(0, tablePtr.asTypedList(ne4));
+      }
+
+      return result;
+    } finally {
+      calloc.free(tablePtr);
+      calloc.free(winnerPtr);
+    }
+  }
+
+  /// Check many boards for conflicts without solving them
+  ///
+  /// Returns one code per board: 0 = CONFLICT, 1 = SOLVED (complete and
+  /// valid), 2 = INCOMPLETE (no conflicts, some cells empty)
+  static List<int> validateBatch(List<List<int>> boards, int n) {
+    _ensureLoaded();
+
+    final ne4 = n * n * n * n;
+    final count = boards.length;
+    if (count == 0) return [];
+
+    final boardsPtr = calloc<Uint8>(ne4 * count);
+    final codesPtr = calloc<Uint8>(count);
+    try {
+      final flat = boardsPtr.asTypedList(ne4 * count);
+      for (int b = 0; b < count; b++) {
+        if (boards[b].length != ne4) {
+          throw ArgumentError('Table length must be $ne4 for n=$n');
+        }
+        flat.setRange(b * ne4, (b + 1) * ne4, boards[b]);
+      }
+
+      _validateBatch!(boardsPtr, n, count, codesPtr);
+      return codesPtr.asTypedList(count).toList();
+    } finally {
+      calloc.free(boardsPtr);
+      calloc.free(codesPtr);
+    }
+  }
+
+  /// Solve many boards in place
+  ///
+  /// 4x4 and 9x9 boards are solved 16 at a time in SIMD lanes; larger ones
+  /// one by one. Each board gets the result and solution [solve] would give.
+  ///
+  /// Returns one result per board: 0 = INVALID, 1 = COMPLETE, 2 = MULTIPLE
+  static List<int> solveBatch(List<List<int>> boards, int n) {
+    _ensureLoaded();
+
+    final ne4 = n * n * n * n;
+    final count = boards.length;
+    if (count == 0) return [];
+
+    final boardsPtr = calloc<Uint8>(ne4 * count);
+    final resultsPtr = calloc<Uint8>(count);
+    try {
+      final flat = boardsPtr.asTypedList(ne4 * count);
+      for (int b = 0; b < count; b++) {
+        if (boards[b].length != ne4) {
+          throw ArgumentError('Table length must be $ne4 for n=$n');
+        }
+        flat.setRange(b * ne4, (b + 1) * ne4, boards[b]);
+      }
+
+      _solveBatch!(boardsPtr, n, count, resultsPtr);
+      final results = resultsPtr.asTypedList(count).toList();
+      for (int b = 0; b < count; b++) {
+        if (results[b] == 1) {
+          boards[b].setAll(0, flat.sublist(b * ne4, (b + 1) * ne4));
+        }
+      }
+      return results;
+    } finally {
+      calloc.free(boardsPtr);
+      calloc.free(resultsPtr);
+    }
+  }
+
+  /// Find the clues that can each be removed while keeping the solution
+  /// unique, checking them in parallel
+  ///
+  /// Returns the indices of the removable clues (empty for a minimal
+  /// puzzle), or null if the puzzle has no unique solution
+  static List<int>? redundantClues(List<int> table, int n) {
+    _ensureLoaded();
+
+    final ne4 = n * n * n * n;
+    if (table.length != ne4) {
+      throw ArgumentError('Table length must be $ne4 for n=$n');
+    }
+
+    final tablePtr = calloc<Uint8>(ne4);
+    final maskPtr = calloc<Uint8>((ne4 + 7) ~/ 8);
+    try {
+      tablePtr.asTypedList(ne4).setAll(0, table);
+
+      if (_checkMinimal!(tablePtr, n, maskPtr) < 0) return null;
+      final mask = maskPtr.asTypedList((ne4 + 7) ~/ 8);
+      return [
+        for (int i = 0; i < ne4; i++)
+          if (mask[i ~/ 8] & (1 << (i % 8)) != 0) i
+      ];
+    } finally {
+      calloc.free(tablePtr);
+      calloc.free(maskPtr);
+    }
+  }
+
   /// Compute a hash seed from puzzle content for deterministic results
   static int _hashPuzzle(List<int> table) {
     // Simple hash combining all values
@@ -210,3 +483,131 @@ class SudokuNative {
   }
 
 }
+
+/// Candidate state of a board in play, kept up to date natively
+///
+/// Assigning or eliminating a candidate propagates naked and hidden singles
+/// over rows, columns and boxes. Each move is recorded on a trail, so [undo]
+/// costs as much as the move did, however long the game. [candidates] and
+/// [values] are views of native memory, updated in place by every call; they
+/// must not be used after [dispose].
+class NativeSession {
+  final int n;
+  Pointer<Void> _handle;
+
+  /// Candidate bitset per cell, bit v-1 set if value v is still possible
+  late final Uint64List candidates;
+
+  /// Placed value per cell (given, assigned or propagated), 0 if open
+  late final Uint8List values;
+
+  NativeSession._(this.n, this._handle) {
+    final ne4 = n * n * n * n;
+    candidates = SudokuNative._sessionCandidates!(_handle).asTypedList(ne4);
+    values = SudokuNative._sessionValues!(_handle).asTypedList(ne4);
+  }
+
+  /// Start a session from the givens of [table] (n = 2..8)
+  ///
+  /// Returns null if the givens conflict.
+  static NativeSession? open(List<int> table, int n) {
+    SudokuNative._ensureLoaded();
+
+    final ne4 = n * n * n * n;
+    if (table.length != ne4) {
+      throw ArgumentError('Table length must be $ne4 for n=$n');
+    }
+
+    final tablePtr = calloc<Uint8>(ne4);
+    try {
+      tablePtr.asTypedList(ne4).setAll(0, table);
+      final handle = SudokuNative._sessionNew!(tablePtr, n);
+      return handle == nullptr ? null : NativeSession._(n, handle);
+    } finally {
+      calloc.free(tablePtr);
+    }
+  }
+
+  /// Whether the board has a cell or unit without candidates
+  bool get conflict => SudokuNative._sessionConflict!(_handle) != 0;
+
+  /// Place [value] (1-based) in [cell]; returns false if this leaves a conflict
+  bool assign(int cell, int value) => _check(SudokuNative._sessionAssign!(_handle, cell, value));
+
+  /// Rule out [value] for [cell]; returns false if this leaves a conflict
+  bool eliminate(int cell, int value) => _check(SudokuNative._sessionEliminate!(_handle, cell, value));
+
+  /// Take back the last move; returns false if there is none
+  bool undo() => SudokuNative._sessionUndo!(_handle) != 0;
+
+  /// Replay the last undone move; returns false if there is none
+  bool redo() => SudokuNative._sessionRedo!(_handle) != 0;
+
+  bool _check(int result) {
+    if (result < 0) {
+      throw RangeError('Cell or value out of range for n=$n');
+    }
+    return result == 1;
+  }
+
+  void dispose() {
+    SudokuNative._sessionFree!(_handle);
+    _handle = nullptr;
+  }
+}
+
+/// A solve that runs in slices of bounded work
+///
+/// For callers that must not block for a whole search, e.g. stepping a hard
+/// 16x16 a little per frame. Slices visit the same nodes as
+/// [SudokuNative.solve] does in one call, so the result and solution are the
+/// same. Call [end] to release the native state.
+class NativeSolve {
+  /// Returned by [step] while the search is unfinished
+  static const int running = 3;
+
+  final int n;
+  Pointer<Void> _handle;
+  int _result = running;
+
+  NativeSolve._(this.n, this._handle);
+
+  /// Prepare to solve [table]; nothing is searched until [step]
+  static NativeSolve begin(List<int> table, int n) {
+    SudokuNative._ensureLoaded();
+
+    final ne4 = n * n * n * n;
+    if (table.length != ne4) {
+      throw ArgumentError('Table length must be $ne4 for n=$n');
+    }
+
+    final tablePtr = calloc<Uint8>(ne4);
+    try {
+      tablePtr.asTypedList(ne4).setAll(0, table);
+      return NativeSolve._(n, SudokuNative._solveBegin!(tablePtr, n));
+    } finally {
+      calloc.free(tablePtr);
+    }
+  }
+
+  /// Search at most [maxNodes] more nodes
+  ///
+  /// Returns [running], or the result as for [SudokuNative.solve] once known.
+  int step(int maxNodes) => _result = SudokuNative._solveStep!(_handle, maxNodes);
+
+  /// Search nodes entered so far
+  int get forwards => SudokuNative._solveForwards!(_handle);
+
+  /// Release the native state; returns the solution if the result was COMPLETE
+  List<int>? end() {
+    final ne4 = n * n * n * n;
+    final tablePtr = calloc<Uint8>(ne4);
+    try {
+      SudokuNative._solveEnd!(_handle, tablePtr);
+      _handle = nullptr;
+      return _result == 1 ? List<int>.from(tablePtr.asTypedList(ne4)) : null;
+    } finally {
+      calloc.free(tablePtr);
+    }
+  }
+}
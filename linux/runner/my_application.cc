@@ -1,5 +1,6 @@
 #include "my_application.h"
 
+#include <dlfcn.h>
 #include <flutter_linux/flutter_linux.h>
 #ifdef GDK_WINDOWING_X11
 #include <gdk/gdkx.h>
@@ -14,6 +15,35 @@ struct _MyApplication {
 
 G_DEFINE_TYPE(MyApplication, my_application, GTK_TYPE_APPLICATION)
 
+// Flags of sd_warmup() in native/sudoku_native.c.
+constexpr int32_t kSdWarmupTopology = 0x1;
+constexpr int32_t kSdWarmupGenerate = 0x2;
+
+// Loads the native solver library and warms it up, so that the first puzzle
+// requested from Dart does not pay for loading it and building its tables.
+// Dart's DynamicLibrary.open() later returns this already-loaded instance.
+static gpointer warmup_native_library(gpointer data) {
+  g_autofree gchar* exe = g_file_read_link("/proc/self/exe", nullptr);
+  if (exe == nullptr) {
+    return nullptr;
+  }
+  g_autofree gchar* dir = g_path_get_dirname(exe);
+  g_autofree gchar* path =
+      g_build_filename(dir, "lib", "libsudoku_native.so", nullptr);
+  // Never closed: the library stays loaded for the lifetime of the process.
+  void* handle = dlopen(path, RTLD_NOW);
+  if (handle == nullptr) {
+    g_warning("Failed to load %s: %s", path, dlerror());
+    return nullptr;
+  }
+  auto sd_warmup =
+      reinterpret_cast<void (*)(int32_t)>(dlsym(handle, "sd_warmup"));
+  if (sd_warmup != nullptr) {
+    sd_warmup(kSdWarmupTopology | kSdWarmupGenerate);
+  }
+  return nullptr;
+}
+
 // Called when first Flutter frame received.
 static void first_frame_cb(MyApplication* self, FlView* view) {
   gtk_widget_show(gtk_widget_get_toplevel(GTK_WIDGET(view)));
@@ -22,6 +52,14 @@ static void first_frame_cb(MyApplication* self, FlView* view) {
 // Implements GApplication::activate.
 static void my_application_activate(GApplication* application) {
   MyApplication* self = MY_APPLICATION(application);
+
+  static gsize warmup_started = 0;
+  if (g_once_init_enter(&warmup_started)) {
+    g_thread_unref(
+        g_thread_new("sudoku-warmup", warmup_native_library, nullptr));
+    g_once_init_leave(&warmup_started, 1);
+  }
+
   GtkWindow* window =
       GTK_WINDOW(gtk_application_window_new(GTK_APPLICATION(application)));
 
@@ -25,6 +25,14 @@
 #include <stdint.h>
 #include <time.h>
 #include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#include <immintrin.h>
+#define SD_X86_SIMD 1
+#endif
 
 /* ============================================================================
  * TYPES AND DECLARATIONS (from algx.h)
@@ -43,9 +51,25 @@ typedef int_fast32_t sz_t;
 
 struct _cov_t;
 struct _sol_t;
+struct _learn_t;
 
 typedef enum { FORWARD, BACKTRACK } ACTION;
 
+/*
+ * Column (constraint) choice at each search node:
+ *   H_MRV        fewest remaining rows, first such column
+ *   H_MRV_FAIL   fewest remaining rows, ties broken by the colfail score
+ *   H_DOM_WDEG   smallest remaining rows / (1 + times the column was exhausted)
+ *   H_MRV_RANDOM fewest remaining rows, ties broken uniformly at random
+ * Rows of the chosen column are tried in slot order, or least-constraining
+ * first when ORDER_LCV is or'ed into the strategy. SEARCH_LEARN switches to
+ * the conflict-learning search, which always tries rows in slot order.
+ */
+typedef enum { H_MRV, H_MRV_FAIL, H_DOM_WDEG, H_MRV_RANDOM, NO_HEURISTICS } HEURISTIC;
+#define ORDER_LCV 0x100
+#define SEARCH_LEARN 0x200
+#define DEFAULT_STRATEGY H_MRV_FAIL
+
 typedef struct _sd_t {
   // general
   sz_t n, ne2, ne3, ne4;
@@ -53,6 +77,7 @@ typedef struct _sd_t {
   // constraint table
   sz_t w, h, wy;
   sz_t *r, *c;
+  bool shared_topology;
   // solver
   sz_t no_hints, no_vars;
   int_fast32_t i;
@@ -60,6 +85,17 @@ typedef struct _sd_t {
   struct _cov_t *cov;
   struct _sol_t *soln;
   val_t *buf;
+  // branching strategy
+  HEURISTIC heuristic;
+  bool lcv;
+  uint32_t rng;
+  // nogoods (SEARCH_LEARN), NULL otherwise
+  struct _learn_t *learn;
+  // grid whose rows are tried first in every column, NULL otherwise
+  const val_t *guide;
+  // set by another thread to stop the search; polled every CANCEL_POLL nodes
+  atomic_int *cancel;
+  bool cancelled;
   // difficulty tracking
   sz_t forward_count;
   sz_t backtrack_count;
@@ -67,7 +103,8 @@ typedef struct _sd_t {
 
 typedef enum { ROWCOL, BOXNUM, ROWNUM, COLNUM, NO_CONSTR } CONSTRAINTS;
 
-typedef enum { INVALID, COMPLETE, MULTIPLE } RESULT;
+// RUNNING: a search given a node budget (sd_search) has not finished yet
+typedef enum { INVALID, COMPLETE, MULTIPLE, RUNNING } RESULT;
 
 typedef struct _cov_t {
   val_t *row, *col;
@@ -84,30 +121,180 @@ typedef struct _min_t {
   sz_t min_col;
   sz_t fail_rate;
   sz_t choice_rate;
+  sz_t ties;
 } min_t;
 
+// set on the count of a covered column
+#define COVERED_BIT ((val_t)(1 << (CHAR_BIT * sizeof(val_t) - 1)))
+
 static const sz_t UNDEF_SIZE = -1;
 
+static inline uint32_t xorshift32_r(uint32_t *state) {
+  uint32_t x = *state;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  return *state = x;
+}
+
 static inline void sd_update(const sd_t *s, sz_t r, ACTION flag);
 static inline void sd_update_min(sd_t *s, sz_t r, ACTION flag, min_t *m);
 static inline void sd_forward(sd_t *s, sz_t r, sz_t c);
 static inline void sd_forward_min(sd_t *s, sz_t r, sz_t c, min_t *m);
 static inline void sd_backtrack(const sd_t *s, sz_t r, sz_t c);
+static struct _learn_t *make_learn(const sd_t *s);
+static RESULT solve_sd_learn(sd_t *s);
+
+/* ============================================================================
+ * VALIDATION
+ * ============================================================================ */
+
+typedef enum { CONFLICT, SOLVED, INCOMPLETE } VALIDITY;
+
+// Largest box size for which a unit's values fit in a 64-bit mask.
+#define VALIDATE_MAX_N 8
+
+/*
+ * Check one board for repeated values in a row, column or box, using a bitmask
+ * per unit. Values above n^2 count as conflicts. Requires n <= VALIDATE_MAX_N.
+ */
+static VALIDITY validate_board(const val_t *table, sz_t n) {
+  const sz_t ne2 = n * n;
+  uint64_t rows[VALIDATE_MAX_N * VALIDATE_MAX_N] = {0}, cols[VALIDATE_MAX_N * VALIDATE_MAX_N] = {0},
+           boxes[VALIDATE_MAX_N * VALIDATE_MAX_N] = {0};
+  bool full = true;
+  for(sz_t r = 0; r < ne2; ++r) {
+    const val_t *row = &table[r * ne2];
+    uint64_t *box = &boxes[r / n * n];
+    for(sz_t c = 0; c < ne2; ++c) {
+      val_t v = row[c];
+      if(!v){full=false;continue;}
+      if(v > ne2)return CONFLICT;
+      uint64_t bit = 1ULL << (v - 1), *b = &box[c / n];
+      if((rows[r] | cols[c] | *b) & bit)return CONFLICT;
+      rows[r] |= bit, cols[c] |= bit, *b |= bit;
+    }
+  }
+  return full ? SOLVED : INCOMPLETE;
+}
+
+#ifdef SD_X86_SIMD
+/*
+ * Lockstep validation of several boards, one board per 32-bit lane. Each cell
+ * contributes 1 << (v-1) to the OR and to the sum of its three units; a unit
+ * holds a repeated value exactly when the two differ. Sums cannot overflow for
+ * n <= 5, which is the limit of these kernels.
+ */
+#define VALIDATE_SIMD_MAX_N 5
+
+// unit ids (row, ne2 + col, 2 * ne2 + box) of every cell
+static void validate_units(sz_t n, uint8_t *units) {
+  const sz_t ne2 = n * n;
+  for(sz_t r = 0; r < ne2; ++r)
+    for(sz_t c = 0; c < ne2; ++c) {
+      uint8_t *u = &units[(r * ne2 + c) * 3];
+      u[0] = r, u[1] = ne2 + c, u[2] = 2 * ne2 + r / n * n + c / n;
+    }
+}
+
+// lane k failed a check when bad[k] != 0, and has no empty cells when full[k] != 0
+static void validate_lanes(const int32_t *full, const int32_t *bad, sz_t lanes, uint8_t *out) {
+  for(sz_t k = 0; k < lanes; ++k)out[k] = bad[k] ? CONFLICT : full[k] ? SOLVED : INCOMPLETE;
+}
+
+static void validate_sse2(const val_t *boards, sz_t n, sz_t count, const uint8_t *units, uint8_t *out) {
+  const sz_t ne2 = n * n, ne4 = ne2 * ne2, nunits = 3 * ne2;
+  __m128i or_acc[3 * VALIDATE_SIMD_MAX_N * VALIDATE_SIMD_MAX_N], sum_acc[3 * VALIDATE_SIMD_MAX_N * VALIDATE_SIMD_MAX_N];
+  const __m128i zero = _mm_setzero_si128(), bias = _mm_set1_epi32(126), limit = _mm_set1_epi32(ne2);
+  for(sz_t b = 0; b + 4 <= count; b += 4) {
+    const val_t *t0 = &boards[b * ne4], *t1 = t0 + ne4, *t2 = t1 + ne4, *t3 = t2 + ne4;
+    for(sz_t u = 0; u < nunits; ++u)or_acc[u] = sum_acc[u] = zero;
+    __m128i full = _mm_set1_epi32(-1), bad = zero;
+    for(sz_t i = 0; i < ne4; ++i) {
+      __m128i v = _mm_setr_epi32(t0[i], t1[i], t2[i], t3[i]);
+      full = _mm_andnot_si128(_mm_cmpeq_epi32(v, zero), full);
+      bad = _mm_or_si128(bad, _mm_cmpgt_epi32(v, limit));
+      // 2^(v-1) through the float exponent; v = 0 gives 0.5, truncated to 0
+      __m128i bit = _mm_cvttps_epi32(_mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(v, bias), 23)));
+      const uint8_t *u = &units[i * 3];
+      for(int k = 0; k < 3; ++k)
+        or_acc[u[k]] = _mm_or_si128(or_acc[u[k]], bit),
+        sum_acc[u[k]] = _mm_add_epi32(sum_acc[u[k]], bit);
+    }
+    for(sz_t u = 0; u < nunits; ++u)bad = _mm_or_si128(bad, _mm_xor_si128(or_acc[u], sum_acc[u]));
+    int32_t lane_full[4], lane_bad[4];
+    _mm_storeu_si128((__m128i *)lane_full, full), _mm_storeu_si128((__m128i *)lane_bad, bad);
+    validate_lanes(lane_full, lane_bad, 4, &out[b]);
+  }
+}
+
+__attribute__((target("avx2")))
+static void validate_avx2(const val_t *boards, sz_t n, sz_t count, const uint8_t *units, uint8_t *out) {
+  const sz_t ne2 = n * n, ne4 = ne2 * ne2, nunits = 3 * ne2;
+  __m256i or_acc[3 * VALIDATE_SIMD_MAX_N * VALIDATE_SIMD_MAX_N], sum_acc[3 * VALIDATE_SIMD_MAX_N * VALIDATE_SIMD_MAX_N];
+  const __m256i zero = _mm256_setzero_si256(), one = _mm256_set1_epi32(1), limit = _mm256_set1_epi32(ne2);
+  for(sz_t b = 0; b + 8 <= count; b += 8) {
+    const val_t *t = &boards[b * ne4];
+    for(sz_t u = 0; u < nunits; ++u)or_acc[u] = sum_acc[u] = zero;
+    __m256i full = _mm256_set1_epi32(-1), bad = zero;
+    for(sz_t i = 0; i < ne4; ++i) {
+      const val_t *p = &t[i];
+      __m256i v = _mm256_setr_epi32(p[0], p[ne4], p[2 * ne4], p[3 * ne4],
+                                    p[4 * ne4], p[5 * ne4], p[6 * ne4], p[7 * ne4]);
+      full = _mm256_andnot_si256(_mm256_cmpeq_epi32(v, zero), full);
+      bad = _mm256_or_si256(bad, _mm256_cmpgt_epi32(v, limit));
+      // shift counts >= 32 (v = 0) yield 0
+      __m256i bit = _mm256_sllv_epi32(one, _mm256_sub_epi32(v, one));
+      const uint8_t *u = &units[i * 3];
+      for(int k = 0; k < 3; ++k)
+        or_acc[u[k]] = _mm256_or_si256(or_acc[u[k]], bit),
+        sum_acc[u[k]] = _mm256_add_epi32(sum_acc[u[k]], bit);
+    }
+    for(sz_t u = 0; u < nunits; ++u)bad = _mm256_or_si256(bad, _mm256_xor_si256(or_acc[u], sum_acc[u]));
+    int32_t lane_full[8], lane_bad[8];
+    _mm256_storeu_si256((__m256i *)lane_full, full), _mm256_storeu_si256((__m256i *)lane_bad, bad);
+    validate_lanes(lane_full, lane_bad, 8, &out[b]);
+  }
+}
+#endif
+
+/*
+ * Validate `count` boards stored back to back (n^4 values each).
+ *
+ * Writes one VALIDITY code per board to out_codes and returns the number of
+ * boards that are complete, valid solutions. Boards are checked in SIMD
+ * lanes where the CPU supports it; the remainder goes through validate_board.
+ */
+int32_t validate_batch(const uint8_t *boards, int32_t n, int32_t count, uint8_t *out_codes) {
+  const sz_t ne4 = n * n * n * n;
+  sz_t done = 0;
+  if(n < 1 || n > VALIDATE_MAX_N) {
+    memset(out_codes, CONFLICT, count);
+    return 0;
+  }
+#ifdef SD_X86_SIMD
+  if(n <= VALIDATE_SIMD_MAX_N) {
+    uint8_t units[VALIDATE_SIMD_MAX_N * VALIDATE_SIMD_MAX_N * VALIDATE_SIMD_MAX_N * VALIDATE_SIMD_MAX_N * 3];
+    validate_units(n, units);
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx2"))
+      validate_avx2(boards, n, count, units, out_codes), done = count / 8 * 8;
+    else
+      validate_sse2(boards, n, count, units, out_codes), done = count / 4 * 4;
+  }
+#endif
+  for(sz_t b = done; b < count; ++b)out_codes[b] = validate_board(&boards[b * ne4], n);
+  int32_t solved = 0;
+  for(sz_t b = 0; b < count; ++b)solved += out_codes[b] == SOLVED;
+  return solved;
+}
 
 /* ============================================================================
  * SOLVER IMPLEMENTATION (from algx.c)
  * ============================================================================ */
 
-static sd_t *make_sd(sz_t n, val_t *table) {
-attributes:;
-  sd_t *s=malloc(sizeof(sd_t));assert(s != NULL);
-  s->n=n, s->ne2=n*n, s->ne3=s->ne2*n, s->ne4=s->ne3 * n;
-  s->table=malloc(sizeof(val_t)*s->ne4),assert(s->table!=NULL);
-  memcpy(s->table, table, sizeof(val_t) * s->ne4);
-  s->forward_count=0, s->backtrack_count=0;
-// constraint table
-  s->w = s->ne4 * NO_CONSTR;
-  s->h = s->ne4 * s->ne2;
+// Row/constraint incidence tables; they depend only on n.
+static void sd_build_topology(sd_t *s) {
 col:;
   s->c=malloc(sizeof(sz_t)*s->h*NO_CONSTR),assert(s->c!=NULL);
   for(sz_t r = 0; r < s->ne2; ++r) {
@@ -132,6 +319,38 @@ row:;
     }
   }
   free(mem);
+}
+
+// Topologies are built once per size and shared read-only between solvers.
+#define TOPOLOGY_CACHE_MAX_N 8
+static pthread_mutex_t topology_mtx = PTHREAD_MUTEX_INITIALIZER;
+static struct { sz_t *r, *c; } topology_cache[TOPOLOGY_CACHE_MAX_N + 1];
+
+static void sd_attach_topology(sd_t *s) {
+  s->shared_topology = s->n <= TOPOLOGY_CACHE_MAX_N;
+  if(!s->shared_topology){sd_build_topology(s);return;}
+  pthread_mutex_lock(&topology_mtx);
+  if(topology_cache[s->n].c == NULL)
+    sd_build_topology(s),
+    topology_cache[s->n].r = s->r, topology_cache[s->n].c = s->c;
+  s->r = topology_cache[s->n].r, s->c = topology_cache[s->n].c;
+  pthread_mutex_unlock(&topology_mtx);
+}
+
+static sd_t *make_sd(sz_t n, val_t *table) {
+attributes:;
+  sd_t *s=malloc(sizeof(sd_t));assert(s != NULL);
+  s->n=n, s->ne2=n*n, s->ne3=s->ne2*n, s->ne4=s->ne3 * n;
+  s->table=malloc(sizeof(val_t)*s->ne4),assert(s->table!=NULL);
+  memcpy(s->table, table, sizeof(val_t) * s->ne4);
+  s->forward_count=0, s->backtrack_count=0;
+  s->heuristic=DEFAULT_STRATEGY, s->lcv=false, s->rng=1;
+  s->learn=NULL, s->guide=NULL;
+  s->cancel=NULL, s->cancelled=false;
+// constraint table
+  s->w = s->ne4 * NO_CONSTR;
+  s->h = s->ne4 * s->ne2;
+  sd_attach_topology(s);
 // solver
 cov:;
   size_t
@@ -163,11 +382,11 @@ ret:;
 
 static void free_sd(sd_t *s) {
   free(s->table);
-  free(s->r);
-  free(s->c);
+  if(!s->shared_topology)free(s->r),free(s->c);
   if(s->cov!=NULL)free(s->cov);
   if(s->soln!=NULL)free(s->soln);
   if(s->buf!=NULL)free(s->buf);
+  if(s->learn!=NULL)free(s->learn);
   free(s);
 }
 
@@ -176,10 +395,53 @@ static inline min_t default_min(const sd_t *s) {
     .min=MINUNDEF,
     .min_col=0,
     .fail_rate=0,
-    .choice_rate=0
+    .choice_rate=0,
+    .ties=0
   };
 }
 
+static void sd_set_strategy(sd_t *s, int32_t strategy, uint32_t seed) {
+  s->heuristic = (strategy & 0xff) < NO_HEURISTICS ? (HEURISTIC)(strategy & 0xff) : DEFAULT_STRATEGY;
+  // a nogood striking out rows while a level is tried would reorder its
+  // remaining rows, so conflict learning keeps to slot order
+  s->lcv = (strategy & ORDER_LCV) != 0 && !(strategy & SEARCH_LEARN);
+  s->rng = seed ? seed : 1;
+  if((strategy & SEARCH_LEARN) && s->learn == NULL)s->learn = make_learn(s);
+}
+
+// Negative if column c is preferable to the current choice m under
+// s->heuristic, zero if it is as good, positive if worse.
+static inline int sd_col_cmp(const sd_t *s, sz_t c, const min_t *m) {
+  const val_t cnt = s->cov->col[c];
+  if(cnt != m->min && s->heuristic != H_DOM_WDEG)return cnt < m->min ? -1 : 1;
+  switch(s->heuristic) {
+    case H_MRV_FAIL:
+      return (s->cov->colfail[c] < m->fail_rate) - (s->cov->colfail[c] > m->fail_rate);
+    case H_DOM_WDEG: {
+      if(cnt & COVERED_BIT)return 1;
+      if(m->min == MINUNDEF)return -1;
+      int64_t a = (int64_t)cnt * (m->fail_rate + 1), b = (int64_t)m->min * (s->cov->colfail[c] + 1);
+      return (a > b) - (a < b);
+    }
+    default:
+      return 0;
+  }
+}
+
+// Whether column c should replace the current choice m; ties are kept, or
+// replaced uniformly at random (reservoir sampling) under H_MRV_RANDOM.
+static inline bool sd_col_better(sd_t *s, sz_t c, min_t *m) {
+  const int cmp = sd_col_cmp(s, c, m);
+  if(cmp < 0){m->ties = 1;return true;}
+  return cmp == 0 && s->heuristic == H_MRV_RANDOM && xorshift32_r(&s->rng) % ++m->ties == 0;
+}
+
+static inline void sd_col_take(sd_t *s, sz_t c, min_t *m) {
+  m->min=s->cov->col[c],m->min_col=c,
+  m->fail_rate=s->cov->colfail[c],
+  m->choice_rate=s->cov->colchoice[c];
+}
+
 static inline void sd_update(const sd_t *s, sz_t r, ACTION flag) {
   const static val_t LBIT = 1 << (CHAR_BIT * sizeof(val_t) - 1);
   for(sz_t ic = 0; ic < NO_CONSTR; ++ic)s->cov->col[C_CNSTR(r, ic)] ^= LBIT;
@@ -221,10 +483,7 @@ static inline void sd_forward_min(sd_t *s, sz_t r, sz_t ic, min_t *m) {
     for(sz_t ic2 = 0; ic2 < NO_CONSTR; ++ic2) {
       sz_t cc = C_CNSTR(rr, ic2);assert(cc < s->w);
       --s->cov->col[cc];
-      if(s->cov->col[cc] < m->min || (s->cov->col[cc] == m->min && s->cov->colfail[cc] > m->fail_rate))
-        m->min=s->cov->col[cc],m->min_col=cc,
-        m->fail_rate=s->cov->colfail[cc],
-        m->choice_rate=s->cov->colchoice[cc];
+      if(sd_col_better(s, cc, m))sd_col_take(s, cc, m);
     }
   }
 }
@@ -237,7 +496,8 @@ static inline void sd_backtrack(const sd_t *s, sz_t r, sz_t ic) {
     sz_t rr = R_SLNS(c, ir);
     assert(rr < s->h);
     --s->cov->row[rr];
-    assert(0 <= s->cov->row[rr] && s->cov->row[rr] <= NO_CONSTR);
+    // one more for a row struck out by clue_redundant or a nogood
+    assert(0 <= s->cov->row[rr] && s->cov->row[rr] <= NO_CONSTR + 1);
     if(s->cov->row[rr] != ROWCOL)continue;
     sz_t *it = &C_CNSTR(rr, 0);
     ++s->cov->col[it[ROWCOL]], ++s->cov->col[it[BOXNUM]],
@@ -246,6 +506,7 @@ static inline void sd_backtrack(const sd_t *s, sz_t r, sz_t ic) {
 }
 
 static inline bool check_sd(sd_t *s) {
+  if(s->n <= VALIDATE_MAX_N)return validate_board(s->table, s->n) != CONFLICT;
   val_t *check = calloc(s->ne2*3, sizeof(val_t));
   assert(check != NULL);
   for(sz_t i = 0; i < s->ne2; ++i) {
@@ -285,25 +546,110 @@ static inline void sd_forward_knowns(sd_t *s) {
   s->no_vars = s->ne4 - s->no_hints;
 }
 
-static RESULT solve_sd(sd_t *s) {
-  RESULT res = INVALID;
-  if(!check_sd(s))return res=INVALID;
-presetup:;
-  sd_forward_knowns(s);
-  min_t m = default_min(s);
-  min_t m2 = default_min(s);
-  (void)m2; // unused but kept for compatibility
+// Sum of the remaining rows over the columns of row rr: how many candidates
+// taking it would disturb.
+static inline sz_t sd_row_score(const sd_t *s, sz_t rr) {
+  const sz_t *it = &C_CNSTR(rr, 0);
+  return s->cov->col[it[ROWCOL]] + s->cov->col[it[BOXNUM]] + s->cov->col[it[ROWNUM]] + s->cov->col[it[COLNUM]];
+}
+
+// Slot of the row of column cc that agrees with s->guide.
+static inline sz_t sd_guide_slot(const sd_t *s, sz_t cc) {
+  for(sz_t cr = 0; cr < s->ne2; ++cr) {
+    sz_t rr = R_SLNS(cc, cr);
+    if(s->guide[rr / s->ne2] == rr % s->ne2 + 1)return cr;
+  }
+  return 0;
+}
+
+// Slot of the next row of column cc to try after slot prev (UNDEF_SIZE for the
+// first); s->ne2 when the column is exhausted.
+static inline sz_t sd_next_row(const sd_t *s, sz_t cc, sz_t prev) {
+  if(s->guide != NULL) {
+    // slot order rotated to start at the guide's row
+    const sz_t g = sd_guide_slot(s, cc);
+    for(sz_t k = (prev == UNDEF_SIZE) ? 0 : (prev + s->ne2 - g) % s->ne2 + 1; k < s->ne2; ++k) {
+      sz_t cr = (g + k) % s->ne2;
+      if(s->cov->row[R_SLNS(cc, cr)] == 0)return cr;
+    }
+    return s->ne2;
+  }
+  if(!s->lcv) {
+    sz_t cr = (prev == UNDEF_SIZE) ? 0 : prev + 1;
+    while(cr < s->ne2) {
+      if(s->cov->row[R_SLNS(cc, cr)] == 0)break;
+      ++cr;
+    }
+    return cr;
+  }
+  // least constraining first; (score, slot) is a total order that is the same
+  // whenever the search returns to this node, so only prev needs storing
+  sz_t prev_score = (prev == UNDEF_SIZE) ? -1 : sd_row_score(s, R_SLNS(cc, prev));
+  sz_t best = s->ne2, best_score = 0;
+  for(sz_t cr = 0; cr < s->ne2; ++cr) {
+    sz_t rr = R_SLNS(cc, cr);
+    if(s->cov->row[rr] != 0)continue;
+    sz_t score = sd_row_score(s, rr);
+    if(score < prev_score || (score == prev_score && cr <= prev))continue;
+    if(best == s->ne2 || score < best_score)best = cr, best_score = score;
+  }
+  return best;
+}
+
+// Score bookkeeping of the stateful heuristics as the search takes a row of
+// column cc, takes it back, or runs out of rows.
+// H_MRV_FAIL weighs a choice by (ne2 / rows left)^2, scaled by the share of
+// cells still open, so tight columns chosen early in the search count most.
+static inline void sd_score_choose(sd_t *s, sz_t cc) {
+  if(s->heuristic != H_MRV_FAIL)return;
+  sz_t diff=(s->ne2/s->cov->col[cc]);diff=diff*diff*(s->no_vars-s->i)/s->w+1;
+  s->cov->colchoice[cc] += diff;
+}
+
+static inline void sd_score_retract(sd_t *s, sz_t cc) {
+  if(s->heuristic == H_MRV_FAIL)s->cov->colfail[cc]=s->cov->colchoice[cc];
+}
+
+static inline void sd_score_exhaust(sd_t *s, sz_t cc) {
+  if(s->heuristic == H_MRV_FAIL) {
+    // an exhausted column also scores the depth it failed at
+    s->cov->colfail[cc] = s->cov->colchoice[cc] + s->i;
+  } else if(s->heuristic == H_DOM_WDEG) {
+    ++s->cov->colfail[cc];
+  }
+}
+
+#define CANCEL_POLL 4096
+
+/*
+ * Run the search from the current node for at most `budget` nodes, or to the
+ * end if budget < 0. *mp and *resp hold the column choice and the result so
+ * far between calls, so a search paused with RUNNING resumes exactly where it
+ * stopped.
+ */
+static RESULT sd_search(sd_t *s, min_t *mp, RESULT *resp, sz_t budget) {
+  min_t m = *mp;
+  RESULT res = *resp;
+  uint_fast32_t poll = 0;
 iterate_unknowns:;
   while(1) {
     while(s->i >= 0 && s->i < s->no_vars) {
+      if(budget >= 0 && budget-- == 0) {
+        *mp = m, *resp = res;
+        return RUNNING;
+      }
+      if(s->cancel != NULL && ++poll % CANCEL_POLL == 0
+         && atomic_load_explicit(s->cancel, memory_order_relaxed)) {
+        s->cancelled = true;
+        goto endsolve;
+      }
       if(s->action == FORWARD) {
         s->soln->col[s->i] = m.min_col;
         if(m.min > 1) {
+          if(s->heuristic == H_MRV_RANDOM)m = default_min(s);
           for(sz_t c = 0; c < s->w; ++c) {
-            if(s->cov->col[c] < m.min || (s->cov->col[c] == m.min && s->cov->colfail[c] > m.fail_rate)) {
-              m.min=s->cov->col[c],m.min_col=c,
-              m.fail_rate=s->cov->colfail[c],
-              m.choice_rate=s->cov->colchoice[c],
+            if(sd_col_better(s, c, &m)) {
+              sd_col_take(s, c, &m),
               s->soln->col[s->i]=c;if(m.min<2)break;
             }
           }
@@ -319,28 +665,20 @@ iterate_unknowns:;
       const sz_t cc = s->soln->col[ii];
       sz_t cr = s->soln->row[ii];
       assert(cc != UNDEF_SIZE && cc < s->h && (cr == UNDEF_SIZE || cr < s->w));
-      if(s->action == BACKTRACK && cr != UNDEF_SIZE)
-        s->cov->colfail[cc]=s->cov->colchoice[cc],
+      if(s->action == BACKTRACK && cr != UNDEF_SIZE) {
+        sd_score_retract(s, cc);
         sd_update(s, R_SLNS(cc, cr), BACKTRACK);
-      cr = (cr == UNDEF_SIZE) ? 0 : cr + 1;
-      while(cr < s->ne2) {
-        if(s->cov->row[R_SLNS(cc, cr)] == 0)break;
-        ++cr;
       }
+      cr = sd_next_row(s, cc, cr);
       if(cr < s->ne2) {
         s->action=FORWARD;
-        // experimental
-        sz_t diff=(s->ne2/s->cov->col[cc]);diff=diff*diff*(s->no_vars-s->i)/s->w+1;
-        s->cov->colchoice[cc] += diff,
-        /* ++s->cov->colchoice[cc], */
+        sd_score_choose(s, cc);
         sd_update_min(s, R_SLNS(cc, cr), FORWARD, &m),
         s->soln->row[ii]=cr;
         ++s->i;
       } else {
-        s->action=BACKTRACK,
-        // experimental
-        s->cov->colfail[cc] = s->cov->colchoice[cc] + s->i,
-        /* s->cov->colfail[cc]=s->cov->colchoice[cc], */
+        s->action=BACKTRACK;
+        sd_score_exhaust(s, cc);
         s->soln->row[ii]=UNDEF_SIZE;
         --s->i;
       }
@@ -362,12 +700,418 @@ iterate_unknowns:;
         goto endsolve;
       break;
       case MULTIPLE:
-        assert(res != MULTIPLE);
+      case RUNNING:
+        assert(res != MULTIPLE && res != RUNNING);
       break;
     }
     --s->i,s->action=BACKTRACK;
   }
 endsolve:
+  *mp = m, *resp = res;
+  return res;
+}
+
+// Place the givens and pick the first column; false if the givens conflict.
+static bool sd_search_start(sd_t *s, min_t *m) {
+  s->cancelled = false;
+  if(!check_sd(s))return false;
+  sd_forward_knowns(s);
+  *m = default_min(s);
+  return true;
+}
+
+static RESULT solve_sd(sd_t *s) {
+  if(s->learn != NULL)return solve_sd_learn(s);
+  RESULT res = INVALID;
+  min_t m;
+  if(!sd_search_start(s, &m))return res=INVALID;
+  return sd_search(s, &m, &res, -1);
+}
+
+/* ============================================================================
+ * CONFLICT LEARNING
+ * ============================================================================ */
+
+/*
+ * SEARCH_LEARN replaces chronological backtracking with conflict-directed
+ * backjumping. Every search level keeps the set of earlier levels that explain
+ * why its rows failed: a row covered before the level was reached blames the
+ * level that covered it, a row whose subtree failed passes on that subtree's
+ * set. An exhausted level jumps straight back to the latest level in its set
+ * and records the rows chosen at those levels as a nogood, a set of rows that
+ * no solution contains. Nogoods of at most NOGOOD_MAX_LEN rows go into a fixed
+ * table where newer ones overwrite older ones, unless the older one is
+ * holding a row struck out.
+ *
+ * Each nogood watches two of its rows that are not placed. Placing a watched
+ * row moves the watch to another row that is not placed; when there is none,
+ * the other watched row is struck out like a covered row until a row of the
+ * nogood is taken back. A fresh nogood watches its two latest rows, so the
+ * row the jump takes back is struck out at once. A watch also remembers a
+ * blocker, a row of its nogood found out of play and not placed: that row
+ * stays out until a level no later than the current one is taken back, so
+ * until then the nogood cannot complete and the watch is skipped.
+ *
+ * The search never restarts: proving a puzzle unique runs it to the end
+ * anyway, and on 25x25 puzzles restarts threw away more than they gained.
+ */
+#define NOGOOD_MAX_LEN 32
+#define NOGOOD_SLOTS 16384
+
+typedef struct _learn_t {
+  int32_t *nogood;      // NOGOOD_SLOTS x NOGOOD_MAX_LEN rows, the watched two first
+  uint64_t *nogood_hash;
+  uint8_t *nogood_len;  // 0 for an empty slot
+  int32_t *watch_head;  // per row: first watch on it, -1 if none
+  int32_t *watch_next;  // per watch (2 * slot + position): next watch on its row
+  int32_t *watch_block; // per watch: row of its nogood last seen out of play
+  int32_t *struck_by;   // per row: slot of the nogood that struck it out, -1 if none
+  int32_t *strike_row;  // per slot: row it struck out, -1 if none
+  int32_t *strike_next; // per slot: next slot that struck out a row at its level
+  int32_t *strike_head; // per level: first slot that struck out a row there
+  int32_t *path_level;  // per row: level it was placed at, -1 if not placed
+  int32_t *col_level;   // per covered column: level that covered it, -1 for hints
+  uint64_t *conf;       // per level: bitset of earlier levels blamed for its failures
+  bool *conf_all;       // per level: a solution lies below, so every level is blamed
+  sz_t words;
+  int32_t pending;      // nogood to assert once the row of the level jumped to is taken back
+  sz_t learned, hits;
+} learn_t;
+
+static learn_t *make_learn(const sd_t *s) {
+  const sz_t words = (s->ne4 + 63) / 64;
+  size_t
+    l_header=sizeof(learn_t),
+    l_conf=sizeof(uint64_t)*s->ne4*words,
+    l_nogood_hash=sizeof(uint64_t)*NOGOOD_SLOTS,
+    l_nogood=sizeof(int32_t)*NOGOOD_SLOTS*NOGOOD_MAX_LEN,
+    l_watch_head=sizeof(int32_t)*s->h,
+    l_watch_next=sizeof(int32_t)*2*NOGOOD_SLOTS,
+    l_watch_block=sizeof(int32_t)*2*NOGOOD_SLOTS,
+    l_struck_by=sizeof(int32_t)*s->h,
+    l_strike_row=sizeof(int32_t)*NOGOOD_SLOTS,
+    l_strike_next=sizeof(int32_t)*NOGOOD_SLOTS,
+    l_strike_head=sizeof(int32_t)*s->ne4,
+    l_path_level=sizeof(int32_t)*s->h,
+    l_col_level=sizeof(int32_t)*s->w,
+    l_nogood_len=sizeof(uint8_t)*NOGOOD_SLOTS,
+    l_conf_all=sizeof(bool)*s->ne4;
+  learn_t *l=malloc(l_header+l_conf+l_nogood_hash+l_nogood+l_watch_head+l_watch_next+l_watch_block+l_struck_by+l_strike_row
+                    +l_strike_next+l_strike_head+l_path_level+l_col_level+l_nogood_len+l_conf_all);
+  assert(l != NULL);
+  void *first = (void *)l;
+  l->conf = (first+=l_header);
+  l->nogood_hash = (first+=l_conf);
+  l->nogood = (first+=l_nogood_hash);
+  l->watch_head = (first+=l_nogood);
+  l->watch_next = (first+=l_watch_head);
+  l->watch_block = (first+=l_watch_next);
+  l->struck_by = (first+=l_watch_block);
+  l->strike_row = (first+=l_struck_by);
+  l->strike_next = (first+=l_strike_row);
+  l->strike_head = (first+=l_strike_next);
+  l->path_level = (first+=l_strike_head);
+  l->col_level = (first+=l_path_level);
+  l->nogood_len = (first+=l_col_level);
+  l->conf_all = (first+=l_nogood_len);
+  l->words=words;
+  return l;
+}
+
+// Nogoods depend on the givens, so every solve starts from an empty table.
+static void learn_reset(sd_t *s) {
+  learn_t *l = s->learn;
+  memset(l->nogood_len, 0, sizeof(uint8_t) * NOGOOD_SLOTS);
+  memset(l->watch_head, 0xff, sizeof(int32_t) * s->h);
+  memset(l->struck_by, 0xff, sizeof(int32_t) * s->h);
+  memset(l->strike_row, 0xff, sizeof(int32_t) * NOGOOD_SLOTS);
+  memset(l->strike_head, 0xff, sizeof(int32_t) * s->ne4);
+  memset(l->path_level, 0xff, sizeof(int32_t) * s->h);
+  memset(l->col_level, 0xff, sizeof(int32_t) * s->w);
+  l->pending=-1;
+  l->learned=0, l->hits=0;
+}
+
+static inline void learn_blame(learn_t *l, sz_t level, int32_t culprit) {
+  if(culprit >= 0)l->conf[level * l->words + culprit / 64] |= (uint64_t)1 << (culprit % 64);
+}
+
+// Blame level L for row rr not being available: the earliest level that
+// covered it, or else the levels of the other rows of the nogood striking it.
+static inline void learn_explain(sd_t *s, sz_t L, sz_t rr) {
+  learn_t *l = s->learn;
+  int32_t culprit = INT32_MAX;
+  for(sz_t ic = 0; ic < NO_CONSTR; ++ic) {
+    sz_t c = C_CNSTR(rr, ic);
+    if((s->cov->col[c] & COVERED_BIT) && l->col_level[c] < culprit)culprit = l->col_level[c];
+  }
+  if(culprit != INT32_MAX) {
+    learn_blame(l, L, culprit);
+    return;
+  }
+  const int32_t slot = l->struck_by[rr];assert(slot >= 0);
+  const int32_t *ng = &l->nogood[slot * NOGOOD_MAX_LEN];
+  for(sz_t j = 0; j < l->nogood_len[slot]; ++j)if(ng[j] != rr)learn_blame(l, L, l->path_level[ng[j]]);
+}
+
+// Strike out row r for the nogood in slot until the row placed at `level` is
+// taken back, or for good if level < 0.
+static void learn_strike(sd_t *s, int32_t slot, sz_t r, sz_t level) {
+  learn_t *l = s->learn;
+  // already out for a nogood that lasts as long; if it does not, this one
+  // fails its last row when that is placed
+  if(l->struck_by[r] >= 0)return;
+  l->struck_by[r] = slot, l->strike_row[slot] = r;
+  if(level >= 0)l->strike_next[slot] = l->strike_head[level], l->strike_head[level] = slot;
+  if(s->cov->row[r]++ == 0)
+    for(sz_t ic = 0; ic < NO_CONSTR; ++ic)--s->cov->col[C_CNSTR(r, ic)];
+  ++l->hits;
+}
+
+// Restore the rows struck out since the row at `level` was placed.
+static void learn_unstrike(sd_t *s, sz_t level) {
+  learn_t *l = s->learn;
+  for(int32_t slot = l->strike_head[level]; slot >= 0; slot = l->strike_next[slot]) {
+    const sz_t r = l->strike_row[slot];
+    l->strike_row[slot] = -1, l->struck_by[r] = -1;
+    if(--s->cov->row[r] == 0)
+      for(sz_t ic = 0; ic < NO_CONSTR; ++ic)++s->cov->col[C_CNSTR(r, ic)];
+  }
+  l->strike_head[level] = -1;
+}
+
+// Strike out the one row of the nogood in slot that is not placed, if all the
+// others are.
+static void learn_assert(sd_t *s, int32_t slot) {
+  learn_t *l = s->learn;
+  const int32_t *ng = &l->nogood[slot * NOGOOD_MAX_LEN];
+  sz_t open = UNDEF_SIZE, level = -1;
+  for(sz_t j = 0; j < l->nogood_len[slot]; ++j) {
+    const sz_t pl = l->path_level[ng[j]];
+    if(pl < 0) {
+      if(open != UNDEF_SIZE)return;
+      open = ng[j];
+    } else if(pl > level) {
+      level = pl;
+    }
+  }
+  if(open != UNDEF_SIZE)learn_strike(s, slot, open, level);
+}
+
+static void learn_unwatch(learn_t *l, int32_t slot) {
+  const int32_t *ng = &l->nogood[slot * NOGOOD_MAX_LEN];
+  for(sz_t k = 0; k < 2 && k < l->nogood_len[slot]; ++k) {
+    int32_t *pw = &l->watch_head[ng[k]];
+    while(*pw != 2 * slot + (int32_t)k)pw = &l->watch_next[*pw];
+    *pw = l->watch_next[*pw];
+  }
+}
+
+// Store the nogood rows[0..len), listed by increasing level while all placed;
+// returns its slot, or -1 if it was not stored.
+static int32_t learn_store(sd_t *s, const int32_t *rows, sz_t len) {
+  learn_t *l = s->learn;
+  if(len == 0 || len > NOGOOD_MAX_LEN)return -1;
+  // independent of the order, so that the same nogood always lands in the same slot
+  uint64_t hash = 0;
+  for(sz_t i = 0; i < len; ++i) {
+    uint64_t x = (uint64_t)(rows[i] + 1) * 0x9e3779b97f4a7c15ULL;
+    hash += x ^ (x >> 29);
+  }
+  const int32_t slot = hash & (NOGOOD_SLOTS - 1);
+  int32_t *ng = &l->nogood[slot * NOGOOD_MAX_LEN];
+  if(l->nogood_len[slot] == len && l->nogood_hash[slot] == hash) {
+    sz_t i = 0, j = 0;
+    for(; i < len; ++i) {
+      for(j = 0; j < len && ng[j] != rows[i]; ++j);
+      if(j == len)break;
+    }
+    if(i == len)return slot;
+  }
+  if(l->strike_row[slot] >= 0)return -1;
+  if(l->nogood_len[slot] != 0)learn_unwatch(l, slot);
+  // the latest row goes first and the one before second
+  ng[0] = rows[len - 1];
+  if(len > 1)ng[1] = rows[len - 2];
+  for(sz_t i = 0; i + 2 < len; ++i)ng[2 + i] = rows[i];
+  l->nogood_len[slot] = len, l->nogood_hash[slot] = hash;
+  for(int32_t k = 0; k < 2 && k < (int32_t)len; ++k)
+    l->watch_next[2 * slot + k] = l->watch_head[ng[k]], l->watch_head[ng[k]] = 2 * slot + k,
+    l->watch_block[2 * slot + k] = ng[len > 1 ? 1 - k : 0];
+  ++l->learned;
+  return slot;
+}
+
+// Row q is out of play, covered or struck out, without being placed.
+static inline bool learn_out(const sd_t *s, int32_t q) {
+  return s->cov->row[q] != 0 && s->learn->path_level[q] < 0;
+}
+
+/*
+ * Visit the nogoods watching row r, just placed at level s->i. Each is skipped
+ * if its blocker is still out, else takes another row out of play as blocker,
+ * moves its watch to a row not placed, or strikes out its other watched row
+ * when none is left. Returns false, blaming the levels of the other rows, if
+ * that row is placed too, so the whole nogood is.
+ */
+static bool learn_propagate(sd_t *s, sz_t r) {
+  learn_t *l = s->learn;
+  for(int32_t *pw = &l->watch_head[r]; *pw >= 0;) {
+    const int32_t w = *pw, slot = w / 2, k = w % 2;
+    if(learn_out(s, l->watch_block[w])) {
+      pw = &l->watch_next[w];
+      continue;
+    }
+    int32_t *ng = &l->nogood[slot * NOGOOD_MAX_LEN];
+    const sz_t len = l->nogood_len[slot];
+    sz_t j = 0, open = len;
+    for(; j < len; ++j) {
+      if(j == k || l->path_level[ng[j]] >= 0)continue;
+      if(s->cov->row[ng[j]] != 0)break;
+      if(j >= 2 && open == len)open = j;
+    }
+    if(j < len) {
+      l->watch_block[w] = ng[j], pw = &l->watch_next[w];
+      continue;
+    }
+    if(open < len) {
+      int32_t t = ng[k];ng[k] = ng[open], ng[open] = t;
+      *pw = l->watch_next[w], l->watch_next[w] = l->watch_head[ng[k]], l->watch_head[ng[k]] = w;
+      continue;
+    }
+    if(len == 1 || l->path_level[ng[1 - k]] >= 0) {
+      for(j = 0; j < len; ++j)if(ng[j] != r)learn_blame(l, s->i, l->path_level[ng[j]]);
+      ++l->hits;
+      return false;
+    }
+    learn_strike(s, slot, ng[1 - k], s->i);
+    pw = &l->watch_next[w];
+  }
+  return true;
+}
+
+static inline void learn_place(sd_t *s, sz_t r) {
+  s->learn->path_level[r] = s->i;
+  for(sz_t ic = 0; ic < NO_CONSTR; ++ic)s->learn->col_level[C_CNSTR(r, ic)] = s->i;
+}
+
+// Take back the row placed at level j and what it struck out.
+static void learn_retract(sd_t *s, sz_t j) {
+  const sz_t cc = s->soln->col[j], r = R_SLNS(cc, s->soln->row[j]);
+  sd_score_retract(s, cc);
+  sd_update(s, r, BACKTRACK);
+  learn_unstrike(s, j);
+  s->learn->path_level[r] = -1;
+}
+
+// Takes back the rows placed at levels below top down to above target.
+static void learn_unwind(sd_t *s, sz_t top, sz_t target) {
+  for(sz_t j = top - 1; j > target; --j)learn_retract(s, j), s->soln->row[j] = UNDEF_SIZE;
+}
+
+static RESULT solve_sd_learn(sd_t *s) {
+  RESULT res = INVALID;
+  learn_t *l = s->learn;
+  s->cancelled = false;
+  if(!check_sd(s))return res=INVALID;
+  sd_forward_knowns(s);
+  learn_reset(s);
+  min_t m = default_min(s);
+  uint_fast32_t poll = 0;
+  while(1) {
+    if(s->cancel != NULL && ++poll % CANCEL_POLL == 0
+       && atomic_load_explicit(s->cancel, memory_order_relaxed)) {
+      s->cancelled = true;
+      break;
+    }
+    if(s->i == s->no_vars) {
+      for(sz_t j = 0; j < s->i; ++j) {
+        sz_t r = R_SLNS(s->soln->col[j], s->soln->row[j]);
+        s->buf[r / s->ne2] = r % s->ne2 + 1;
+      }
+      if(res != INVALID) {
+        res = MULTIPLE;
+        break;
+      }
+      res = COMPLETE;
+      memcpy(s->table, s->buf, sizeof(val_t) * s->ne4);
+      // every level above a solution must try its other rows
+      if(s->i == 0)break;
+      --s->i, s->action = BACKTRACK;
+      l->conf_all[s->i] = true;
+      continue;
+    }
+    const sz_t L = s->i;
+    if(s->action == FORWARD) {
+      sz_t cc = m.min_col;
+      if(m.min > 1) {
+        if(s->heuristic == H_MRV_RANDOM)m = default_min(s);
+        for(sz_t c = 0; c < s->w; ++c) {
+          if(sd_col_better(s, c, &m)) {
+            sd_col_take(s, c, &m), cc = c;
+            if(m.min < 2)break;
+          }
+        }
+      }
+      s->soln->col[L] = cc, s->soln->row[L] = UNDEF_SIZE;
+      memset(&l->conf[L * l->words], 0, sizeof(uint64_t) * l->words), l->conf_all[L] = false;
+    }
+    const sz_t cc = s->soln->col[L];
+    sz_t cr = s->soln->row[L];
+    if(s->action == BACKTRACK && cr != UNDEF_SIZE) {
+      learn_retract(s, L);
+      // the nogood learned by the jump here now strikes out the row just taken back
+      if(l->pending >= 0)learn_assert(s, l->pending), l->pending = -1;
+    }
+    cr = sd_next_row(s, cc, cr);
+    if(cr < s->ne2) {
+      const sz_t r = R_SLNS(cc, cr);
+      sd_score_choose(s, cc);
+      sd_update_min(s, r, FORWARD, &m);
+      learn_place(s, r);
+      s->soln->row[L] = cr;
+      const sz_t hits = l->hits;
+      // a completed nogood fails the row on the spot
+      if(!learn_propagate(s, r))s->action = BACKTRACK;
+      else s->action = FORWARD, ++s->i;
+      // struck out rows change counts the incremental choice did not see
+      if(l->hits != hits)m = default_min(s);
+      continue;
+    }
+    // column exhausted: blame the rows still out of play, learn, then jump
+    // back to the latest blamed level
+    sd_score_exhaust(s, cc);
+    s->soln->row[L] = UNDEF_SIZE;
+    for(cr = 0; cr < s->ne2; ++cr) {
+      sz_t rr = R_SLNS(cc, cr);
+      if(s->cov->row[rr] != 0)learn_explain(s, L, rr);
+    }
+    int32_t rows[NOGOOD_MAX_LEN];
+    sz_t len = 0, target = -1;
+    const uint64_t *conf = &l->conf[L * l->words];
+    if(l->conf_all[L]) {
+      target = L - 1;
+      if(L <= NOGOOD_MAX_LEN)
+        for(sz_t j = 0; j < L; ++j)rows[len++] = R_SLNS(s->soln->col[j], s->soln->row[j]);
+    } else {
+      for(sz_t wi = 0; wi < l->words; ++wi) {
+        for(uint64_t bits = conf[wi]; bits; bits &= bits - 1) {
+          sz_t j = wi * 64 + __builtin_ctzll(bits);
+          target = j;
+          if(len < NOGOOD_MAX_LEN)rows[len] = R_SLNS(s->soln->col[j], s->soln->row[j]);
+          ++len;
+        }
+      }
+    }
+    const int32_t slot = learn_store(s, rows, len);
+    if(target < 0)break;
+    uint64_t *up = &l->conf[target * l->words];
+    for(sz_t wi = 0; wi < l->words; ++wi)up[wi] |= conf[wi];
+    up[target / 64] &= ~((uint64_t)1 << (target % 64));
+    l->conf_all[target] |= l->conf_all[L];
+    learn_unwind(s, L, target);
+    s->i = target, s->action = BACKTRACK, l->pending = slot;
+  }
   return res;
 }
 
@@ -375,15 +1119,11 @@ endsolve:
  * ISOMORPHIC TRANSFORMATIONS
  * ============================================================================ */
 
-static uint32_t xorshift_state = 1;
+// Per-thread so that independent generators can run concurrently.
+static _Thread_local uint32_t xorshift_state = 1;
 
 static uint32_t xorshift32(void) {
-  uint32_t x = xorshift_state;
-  x ^= x << 13;
-  x ^= x >> 17;
-  x ^= x << 5;
-  xorshift_state = x;
-  return x;
+  return xorshift32_r(&xorshift_state);
 }
 
 static void shuffle_array(sz_t *arr, sz_t len) {
@@ -393,14 +1133,16 @@ static void shuffle_array(sz_t *arr, sz_t len) {
   }
 }
 
-/* Apply isomorphic transformation to puzzle:
+/* Draw an isomorphic transformation:
  * - Shuffle rows within each band
  * - Shuffle columns within each stack
  * - Shuffle bands
  * - Shuffle stacks
  * - Relabel values
+ * cell_map[i] is where cell i goes (n^4 entries), value_map[v] what value v
+ * becomes (n^2 + 1 entries, 0 stays 0).
  */
-static void apply_isomorphism(val_t *src, val_t *dst, sz_t n, uint32_t seed) {
+static void make_isomorphism(sz_t n, uint32_t seed, sz_t *cell_map, val_t *value_map) {
   sz_t ne2 = n * n;
   xorshift_state = seed;
 
@@ -427,8 +1169,9 @@ static void apply_isomorphism(val_t *src, val_t *dst, sz_t n, uint32_t seed) {
   value_perm[0] = 0;
   for(sz_t i = 1; i <= ne2; ++i)value_perm[i] = i;
   shuffle_array(&value_perm[1], ne2);
+  for(sz_t i = 0; i <= ne2; ++i)value_map[i] = value_perm[i];
 
-  // Apply transformation
+  // Compose the cell mapping
   for(sz_t row = 0; row < ne2; ++row) {
     sz_t src_band = row / n, src_row_in_band = row % n;
     sz_t dst_band = band_perm[src_band];
@@ -441,14 +1184,30 @@ static void apply_isomorphism(val_t *src, val_t *dst, sz_t n, uint32_t seed) {
       sz_t dst_col_in_stack = col_in_stack[dst_stack * n + src_col_in_stack];
       sz_t dst_col = dst_stack * n + dst_col_in_stack;
 
-      val_t val = src[row * ne2 + col];
-      dst[dst_row * ne2 + dst_col] = value_perm[val];
+      cell_map[row * ne2 + col] = dst_row * ne2 + dst_col;
     }
   }
 
   free(band_perm),free(stack_perm),free(row_in_band),free(col_in_stack),free(value_perm);
 }
 
+static void apply_isomorphism(val_t *src, val_t *dst, sz_t n, uint32_t seed) {
+  sz_t ne2 = n * n, ne4 = ne2 * ne2;
+  sz_t *cell_map = malloc(sizeof(sz_t) * ne4);
+  val_t *value_map = malloc(sizeof(val_t) * (ne2 + 1));
+  make_isomorphism(n, seed, cell_map, value_map);
+  for(sz_t i = 0; i < ne4; ++i)dst[cell_map[i]] = value_map[src[i]];
+  free(cell_map),free(value_map);
+}
+
+// Undo make_isomorphism: dst is a transformed table, src receives the original.
+static void invert_isomorphism(const val_t *dst, val_t *src, sz_t n, const sz_t *cell_map, const val_t *value_map) {
+  sz_t ne2 = n * n, ne4 = ne2 * ne2;
+  val_t inverse[UCHAR_MAX + 1];
+  for(sz_t v = 0; v <= ne2; ++v)inverse[value_map[v]] = v;
+  for(sz_t i = 0; i < ne4; ++i)src[i] = inverse[dst[cell_map[i]]];
+}
+
 /* ============================================================================
  * DIFFICULTY ESTIMATION
  * ============================================================================ */
@@ -535,57 +1294,464 @@ int estimate_difficulty(const uint8_t *table, int32_t n, int32_t num_samples,
 }
 
 /* ============================================================================
- * GENERATOR (from sudoku_generator.c)
+ * PORTFOLIO SOLVING
  * ============================================================================ */
 
+// Worker k uses strategy k % NO_PORTFOLIO_STRATEGIES; worker 0 solves the
+// puzzle as given, the others a random isomorph of it.
+static const int32_t portfolio_strategies[] = {
+  H_MRV_FAIL, H_MRV_RANDOM, H_MRV_FAIL | ORDER_LCV, H_MRV,
+};
+#define NO_PORTFOLIO_STRATEGIES (sizeof(portfolio_strategies) / sizeof(portfolio_strategies[0]))
+#define PORTFOLIO_MAX_THREADS 16
+
 typedef struct {
-  sz_t n, ne2, ne4;
-  sd_t *solver;
-  val_t *table;
-  RESULT status;
-  sz_t no_vals;
-} sdgen_t;
+  const val_t *table;
+  sz_t n;
+  uint32_t seed;
+  atomic_int done;
+  pthread_mutex_t mtx;
+  RESULT result;
+  int32_t winner;
+  val_t *solution;
+} portfolio_t;
 
-static sdgen_t sdgen_init(sz_t n) {
-  sdgen_t s={.n=n,.ne2=n*n,.ne4=n*n*n*n,.solver=NULL,.table=malloc(sizeof(val_t)*n*n*n*n),
-    .status=MULTIPLE,.no_vals=0};
-  assert(s.table!=NULL),memset(s.table,0x00,sizeof(val_t)*s.ne4);
-  return s;
+typedef struct {
+  portfolio_t *p;
+  int32_t k;
+} portfolio_worker_t;
+
+static void *portfolio_worker(void *arg) {
+  const portfolio_worker_t *w = arg;
+  portfolio_t *p = w->p;
+  const sz_t ne2 = p->n * p->n, ne4 = ne2 * ne2;
+  const uint32_t seed = (p->seed ^ ((uint32_t)w->k * 0x9e3779b9u)) | 1;
+  val_t *table = malloc(sizeof(val_t) * ne4);assert(table != NULL);
+  sz_t *cell_map = NULL;
+  val_t value_map[UCHAR_MAX + 1];
+  if(w->k == 0) {
+    memcpy(table, p->table, sizeof(val_t) * ne4);
+  } else {
+    cell_map = malloc(sizeof(sz_t) * ne4),assert(cell_map != NULL);
+    make_isomorphism(p->n, seed, cell_map, value_map);
+    for(sz_t i = 0; i < ne4; ++i)table[cell_map[i]] = value_map[p->table[i]];
+  }
+  sd_t *s = make_sd(p->n, table);
+  sd_set_strategy(s, portfolio_strategies[w->k % NO_PORTFOLIO_STRATEGIES], seed);
+  s->cancel = &p->done;
+  RESULT res = solve_sd(s);
+  if(!s->cancelled) {
+    pthread_mutex_lock(&p->mtx);
+    if(p->winner < 0) {
+      p->result = res, p->winner = w->k;
+      if(res == COMPLETE) {
+        if(cell_map != NULL)invert_isomorphism(s->table, p->solution, p->n, cell_map, value_map);
+        else memcpy(p->solution, s->table, sizeof(val_t) * ne4);
+      }
+      atomic_store(&p->done, 1);
+    }
+    pthread_mutex_unlock(&p->mtx);
+  }
+  free_sd(s);
+  free(table),free(cell_map);
+  return NULL;
 }
 
-static void sdgen_free(sdgen_t *s){if(s->solver)free_sd(s->solver);free(s->table);}
+/*
+ * Race several solvers on the same puzzle and return the first answer.
+ *
+ * Search effort on isomorphs of one puzzle is heavy-tailed, so solving
+ * differently transformed copies with different strategies and keeping the
+ * fastest cuts tail latency. Every worker searches exhaustively, so the first
+ * to finish has the definitive answer; the others are cancelled.
+ *
+ * Parameters:
+ *   table: puzzle values, replaced by the solution when COMPLETE
+ *   n: box size
+ *   threads: number of workers (<= 0 = online cores), at most PORTFOLIO_MAX_THREADS
+ *   seed: seed for isomorphs and random tie-breaking
+ *   out_winner: index of the worker that answered (0 = untransformed puzzle)
+ *
+ * Without thread support only worker 0 runs.
+ */
+RESULT solve_portfolio(uint8_t *table, int32_t n, int32_t threads, uint32_t seed, int32_t *out_winner) {
+  if(threads <= 0)threads = (int32_t)sysconf(_SC_NPROCESSORS_ONLN);
+  if(threads < 1)threads = 1;
+  if(threads > PORTFOLIO_MAX_THREADS)threads = PORTFOLIO_MAX_THREADS;
+  const sz_t ne4 = n * n * n * n;
+  portfolio_t p = {.table=table, .n=n, .seed=seed, .result=INVALID, .winner=-1};
+  atomic_init(&p.done, 0);
+  pthread_mutex_init(&p.mtx, NULL);
+  p.solution = malloc(sizeof(val_t) * ne4),assert(p.solution != NULL);
+  pthread_t tids[PORTFOLIO_MAX_THREADS];
+  portfolio_worker_t workers[PORTFOLIO_MAX_THREADS];
+  bool started[PORTFOLIO_MAX_THREADS] = {false};
+  for(int32_t k = 0; k < threads; ++k)workers[k] = (portfolio_worker_t){.p=&p, .k=k};
+  for(int32_t k = 1; k < threads; ++k)
+    started[k] = pthread_create(&tids[k], NULL, portfolio_worker, &workers[k]) == 0;
+  portfolio_worker(&workers[0]);
+  for(int32_t k = 1; k < threads; ++k)if(started[k])pthread_join(tids[k], NULL);
+  if(p.result == COMPLETE)memcpy(table, p.solution, sizeof(val_t) * ne4);
+  if(out_winner != NULL)*out_winner = p.winner;
+  free(p.solution);
+  pthread_mutex_destroy(&p.mtx);
+  return p.result;
+}
 
-static void ord_arr(sz_t *arr, sz_t len){for(sz_t i=0;i<len;++i)arr[i]=i;}
+/* ============================================================================
+ * STEPPED SOLVING
+ * ============================================================================ */
 
-static void gen_shuffle_arr(sz_t *arr, sz_t len) {
-  for(sz_t i = 1; i < len; ++i) {
-    sz_t j = xorshift32()%i;
-    sz_t tmp;if(i!=j)tmp=arr[i],arr[i]=arr[j],arr[j]=tmp;
-  }
+/*
+ * A default-strategy solve run in slices, for hosts that cannot block for a
+ * whole search, e.g. a single-threaded __EMSCRIPTEN__ build solving a 16x16
+ * between frames. The search state already lives in sd_t; only the column
+ * choice and the result so far are kept here between slices. Slices visit
+ * exactly the nodes of one solve_sd call, so the result, solution and
+ * forwards are the same.
+ */
+typedef struct {
+  sd_t *s;
+  min_t m;
+  RESULT found;   // solutions so far: INVALID (none), COMPLETE (one)
+  RESULT status;  // RUNNING, then the final result
+} solve_task_t;
+
+static solve_task_t *make_solve_task(val_t *table, sz_t n) {
+  solve_task_t *t = malloc(sizeof(solve_task_t));assert(t != NULL);
+  t->s = make_sd(n, table);
+  t->found = INVALID;
+  t->status = sd_search_start(t->s, &t->m) ? RUNNING : INVALID;
+  return t;
 }
 
-static void sd_fill_box(sdgen_t *s, sz_t box_idx) {
-  sz_t *arr = malloc(sizeof(sz_t) * s->ne2);
-  ord_arr(arr, s->ne2),gen_shuffle_arr(arr, s->ne2);
-  for(sz_t j=0;j<s->ne2;++j) {
-    sz_t row = s->n * (box_idx / s->n) + (j / s->n);
-    sz_t col = s->n * (box_idx % s->n) + (j % s->n);
-    s->table[row * s->ne2 + col] = arr[j] + 1,++s->no_vals;
-  }
-  free(arr);
+// Run at most max_nodes more nodes; RUNNING until the result is known.
+static RESULT solve_task_step(solve_task_t *t, sz_t max_nodes) {
+  if(t->status == RUNNING)t->status = sd_search(t->s, &t->m, &t->found, max_nodes);
+  return t->status;
 }
 
-static void sd_init_diagonal_boxes(sdgen_t *s) {
-  sz_t *ys = malloc(sizeof(sz_t) * s->n);
-  ord_arr(ys, s->n),gen_shuffle_arr(ys, s->n);
-  for(sz_t i = 0; i < s->n; ++i)sd_fill_box(s, ys[i] * s->n + i);
-  free(ys);
+static void free_solve_task(solve_task_t *t) {
+  free_sd(t->s);
+  free(t);
 }
 
-static void setboard_gen(sdgen_t *s) {
-  if(s->solver==NULL)s->solver=make_sd(s->n,s->table);
-  else memcpy(s->solver->table, s->table, sizeof(val_t) * s->ne4);
-}
+/* ============================================================================
+ * BATCH SOLVING
+ * ============================================================================ */
+
+/*
+ * Small puzzles solved many at a time. A vector holds one cell's candidate
+ * bits for BATCH_LANES puzzles, one per 16-bit lane, so each operation below
+ * advances every puzzle of the batch: naked singles (a placed value leaves
+ * its units) and hidden singles (a value with one possible cell in a unit goes
+ * there) are propagated in lockstep to a common fixpoint. Then each lane
+ * takes one search step of its own, branching or backtracking on a stack of
+ * saved grids, and the batch propagates again. A lane that finishes its board
+ * loads the next one, and a board whose search gets too deep or too long is
+ * handed to solve_sd, so lanes stay busy until the input runs out.
+ *
+ * The kernel is written with GCC vector extensions: on AVX2 one vector covers
+ * all 16 lanes; elsewhere (SSE2, NEON) the two halves of 8 lanes are
+ * propagated one after the other.
+ */
+#define BATCH_LANES 16
+#define BATCH_MAX_N 3
+// A lane hands its board to solve_sd past this many nested or total branches.
+#define BATCH_MAX_DEPTH 64
+#define BATCH_MAX_NODES 4096
+
+#ifdef __GNUC__
+#define SD_BATCH_SIMD 1
+typedef uint16_t batch_vec_t __attribute__((vector_size(2 * BATCH_LANES)));
+// Half of the lanes: what one SSE2 or NEON register holds.
+typedef uint16_t batch_half_t __attribute__((vector_size(BATCH_LANES), may_alias));
+
+// cells of each unit: rows, then columns, then boxes
+static void batch_unit_cells(sz_t n, uint8_t *unit_cells) {
+  const sz_t ne2 = n * n;
+  for(sz_t r = 0; r < ne2; ++r)
+    for(sz_t c = 0; c < ne2; ++c) {
+      sz_t box = r / n * n + c / n, slot = r % n * n + c % n;
+      unit_cells[r * ne2 + c] = unit_cells[(ne2 + c) * ne2 + r] =
+        unit_cells[(2 * ne2 + box) * ne2 + slot] = r * ne2 + c;
+    }
+}
+
+/*
+ * Propagate singles to a fixpoint in the lanes of cand, n^4 vectors found
+ * `stride` apart. Lane k of out_bad is set when its puzzle has a cell or unit
+ * without candidates or a value placed twice in a unit.
+ */
+static void batch_propagate(batch_half_t *cand, sz_t stride, sz_t n, const uint8_t *unit_cells, uint16_t *out_bad) {
+  const sz_t ne2 = n * n, nunits = 3 * ne2;
+  const batch_half_t zero = {0}, full = zero + (uint16_t)((1u << ne2) - 1);
+  batch_half_t bad = zero, diff;
+  bool changed;
+  do {
+    diff = zero;
+    for(sz_t u = 0; u < nunits; ++u) {
+      const uint8_t *cells = &unit_cells[u * ne2];
+      batch_half_t fixed = zero, once = zero, twice = zero;
+      for(sz_t j = 0; j < ne2; ++j) {
+        batch_half_t c = cand[cells[j] * stride], single = c & (batch_half_t)((c & (c - 1)) == zero);
+        bad |= fixed & single, fixed |= single;
+        twice |= once & c, once |= c;
+      }
+      bad |= once ^ full;
+      const batch_half_t hidden = once & ~twice & ~fixed;
+      for(sz_t j = 0; j < ne2; ++j) {
+        batch_half_t c = cand[cells[j] * stride], multi = (batch_half_t)((c & (c - 1)) != zero);
+        batch_half_t nc = c & ~(fixed & multi), h = nc & hidden, has = (batch_half_t)(h != zero);
+        nc = (h & has) | (nc & ~has);
+        bad |= (h & (h - 1)) | (batch_half_t)(nc == zero);
+        diff |= nc ^ c, cand[cells[j] * stride] = nc;
+      }
+    }
+    changed = false;
+    for(sz_t k = 0; k < BATCH_LANES / 2; ++k)changed |= diff[k] != 0;
+  } while(changed);
+  for(sz_t k = 0; k < BATCH_LANES / 2; ++k)out_bad[k] = bad[k];
+}
+
+#ifdef SD_X86_SIMD
+// batch_propagate over all lanes at once.
+__attribute__((target("avx2")))
+static void batch_propagate_avx2(batch_vec_t *cand, sz_t n, const uint8_t *unit_cells, uint16_t *out_bad) {
+  const sz_t ne2 = n * n, nunits = 3 * ne2;
+  const batch_vec_t zero = {0}, full = zero + (uint16_t)((1u << ne2) - 1);
+  batch_vec_t bad = zero, diff;
+  bool changed;
+  do {
+    diff = zero;
+    for(sz_t u = 0; u < nunits; ++u) {
+      const uint8_t *cells = &unit_cells[u * ne2];
+      batch_vec_t fixed = zero, once = zero, twice = zero;
+      for(sz_t j = 0; j < ne2; ++j) {
+        batch_vec_t c = cand[cells[j]], single = c & (batch_vec_t)((c & (c - 1)) == zero);
+        bad |= fixed & single, fixed |= single;
+        twice |= once & c, once |= c;
+      }
+      bad |= once ^ full;
+      const batch_vec_t hidden = once & ~twice & ~fixed;
+      for(sz_t j = 0; j < ne2; ++j) {
+        batch_vec_t c = cand[cells[j]], multi = (batch_vec_t)((c & (c - 1)) != zero);
+        batch_vec_t nc = c & ~(fixed & multi), h = nc & hidden, has = (batch_vec_t)(h != zero);
+        nc = (h & has) | (nc & ~has);
+        bad |= (h & (h - 1)) | (batch_vec_t)(nc == zero);
+        diff |= nc ^ c, cand[cells[j]] = nc;
+      }
+    }
+    changed = false;
+    for(sz_t k = 0; k < BATCH_LANES; ++k)changed |= diff[k] != 0;
+  } while(changed);
+  for(sz_t k = 0; k < BATCH_LANES; ++k)out_bad[k] = bad[k];
+}
+#endif
+
+typedef struct {
+  sz_t board;       // index of the board in the lane, -1 when idle
+  sz_t depth, nodes;
+  int32_t solutions;
+} batch_lane_t;
+
+typedef struct {
+  uint8_t *boards, *results;
+  sz_t n, ne2, ne4, count, next, dropped;
+  batch_vec_t cand[BATCH_MAX_N * BATCH_MAX_N * BATCH_MAX_N * BATCH_MAX_N];
+  uint16_t *stack;  // per lane, BATCH_MAX_DEPTH saved candidate grids
+  val_t *solution;  // per lane, the first solution found
+  batch_lane_t lanes[BATCH_LANES];
+} batch_t;
+
+// Put the next unsolved board into lane k, or leave it idle without candidates.
+static void batch_lane_load(batch_t *bt, sz_t k) {
+  const uint16_t all = (1u << bt->ne2) - 1;
+  batch_lane_t *l = &bt->lanes[k];
+  *l = (batch_lane_t){.board=-1};
+  if(bt->next == bt->count) {
+    for(sz_t i = 0; i < bt->ne4; ++i)bt->cand[i][k] = 0;
+    return;
+  }
+  l->board = bt->next++;
+  const uint8_t *board = &bt->boards[l->board * bt->ne4];
+  for(sz_t i = 0; i < bt->ne4; ++i) {
+    uint8_t v = board[i];
+    bt->cand[i][k] = !v ? all : v <= bt->ne2 ? 1u << (v - 1) : 0;
+  }
+}
+
+static void batch_lane_finish(batch_t *bt, sz_t k, RESULT res) {
+  batch_lane_t *l = &bt->lanes[k];
+  if(res == COMPLETE)memcpy(&bt->boards[l->board * bt->ne4], &bt->solution[k * bt->ne4], sizeof(val_t) * bt->ne4);
+  bt->results[l->board] = res;
+  batch_lane_load(bt, k);
+}
+
+// Too deep or too long for the lanes: solve the original board with solve_sd.
+static void batch_lane_drop(batch_t *bt, sz_t k) {
+  uint8_t *board = &bt->boards[bt->lanes[k].board * bt->ne4];
+  sd_t *s = make_sd(bt->n, board);
+  RESULT res = solve_sd(s);
+  if(res == COMPLETE)memcpy(&bt->solution[k * bt->ne4], s->table, sizeof(val_t) * bt->ne4);
+  free_sd(s);
+  ++bt->dropped;
+  batch_lane_finish(bt, k, res);
+}
+
+/*
+ * Advance lane k after propagation: branch on the cell with the fewest
+ * candidates, taking its lowest value and saving the grid without it as the
+ * alternative, or backtrack to the last saved grid after a conflict or a
+ * solution. A lane is done when its stack runs out or a second solution turns
+ * up.
+ */
+static void batch_lane_step(batch_t *bt, sz_t k, bool bad) {
+  batch_lane_t *l = &bt->lanes[k];
+  const sz_t ne4 = bt->ne4;
+  uint16_t *saved = &bt->stack[k * BATCH_MAX_DEPTH * ne4];
+  if(!bad) {
+    sz_t cell = -1;
+    int best = bt->ne2 + 1;
+    for(sz_t i = 0; i < ne4 && best > 2; ++i) {
+      int count = __builtin_popcount(bt->cand[i][k]);
+      if(count > 1 && count < best)best = count, cell = i;
+    }
+    if(cell >= 0) {
+      if(l->depth == BATCH_MAX_DEPTH || ++l->nodes > BATCH_MAX_NODES) {
+        batch_lane_drop(bt, k);
+        return;
+      }
+      uint16_t c = bt->cand[cell][k], v = c & -c;
+      uint16_t *grid = &saved[l->depth++ * ne4];
+      for(sz_t i = 0; i < ne4; ++i)grid[i] = bt->cand[i][k];
+      grid[cell] = c & ~v, bt->cand[cell][k] = v;
+      return;
+    }
+    if(++l->solutions > 1) {
+      batch_lane_finish(bt, k, MULTIPLE);
+      return;
+    }
+    for(sz_t i = 0; i < ne4; ++i)bt->solution[k * ne4 + i] = __builtin_ctz(bt->cand[i][k]) + 1;
+  }
+  if(l->depth == 0) {
+    batch_lane_finish(bt, k, l->solutions ? COMPLETE : INVALID);
+    return;
+  }
+  const uint16_t *grid = &saved[--l->depth * ne4];
+  for(sz_t i = 0; i < ne4; ++i)bt->cand[i][k] = grid[i];
+}
+
+// Solve all boards through the lanes, refilling each lane as its board is done.
+static void solve_batch_lanes(batch_t *bt) {
+  uint8_t unit_cells[3 * BATCH_MAX_N * BATCH_MAX_N * BATCH_MAX_N * BATCH_MAX_N];
+  uint16_t bad[BATCH_LANES];
+  batch_unit_cells(bt->n, unit_cells);
+  bool avx2 = false;
+#ifdef SD_X86_SIMD
+  __builtin_cpu_init();
+  avx2 = __builtin_cpu_supports("avx2");
+#endif
+  (void)avx2;
+  for(sz_t k = 0; k < BATCH_LANES; ++k)batch_lane_load(bt, k);
+  while(1) {
+    bool active = false;
+    for(sz_t k = 0; k < BATCH_LANES; ++k)active |= bt->lanes[k].board >= 0;
+    if(!active)break;
+#ifdef SD_X86_SIMD
+    if(avx2)batch_propagate_avx2(bt->cand, bt->n, unit_cells, bad);
+    else
+#endif
+    for(sz_t h = 0; h < 2; ++h)
+      batch_propagate((batch_half_t *)bt->cand + h, 2, bt->n, unit_cells, &bad[h * BATCH_LANES / 2]);
+    for(sz_t k = 0; k < BATCH_LANES; ++k)
+      if(bt->lanes[k].board >= 0)batch_lane_step(bt, k, bad[k] != 0);
+  }
+}
+#endif
+
+/*
+ * Solve `count` boards stored back to back (n^4 values each) in place.
+ *
+ * Writes one RESULT per board to out_results, replacing a board by its
+ * solution when COMPLETE, exactly as solve_sd would. Boards with n <=
+ * BATCH_MAX_N go through the lockstep kernel, others through solve_sd one by
+ * one. out_dropped (if not NULL) receives the number of boards solved by
+ * solve_sd. Returns the number of COMPLETE boards.
+ */
+int32_t solve_batch(uint8_t *boards, int32_t n, int32_t count, uint8_t *out_results, int32_t *out_dropped) {
+  const sz_t ne4 = n * n * n * n;
+  sz_t done = 0, dropped = 0;
+  if(n < 1) {
+    memset(out_results, INVALID, count);
+    return 0;
+  }
+#ifdef SD_BATCH_SIMD
+  if(n >= 2 && n <= BATCH_MAX_N) {
+    batch_t bt = {.boards=boards, .results=out_results, .n=n, .ne2=n * n, .ne4=ne4, .count=count};
+    bt.stack = malloc(sizeof(uint16_t) * BATCH_LANES * BATCH_MAX_DEPTH * ne4);
+    bt.solution = malloc(sizeof(val_t) * BATCH_LANES * ne4);
+    assert(bt.stack != NULL && bt.solution != NULL);
+    solve_batch_lanes(&bt);
+    free(bt.stack),free(bt.solution);
+    done = count, dropped = bt.dropped;
+  }
+#endif
+  for(sz_t b = done; b < count; ++b) {
+    sd_t *s = make_sd(n, &boards[b * ne4]);
+    RESULT res = solve_sd(s);
+    if(res == COMPLETE)memcpy(&boards[b * ne4], s->table, sizeof(val_t) * ne4);
+    free_sd(s);
+    out_results[b] = res, ++dropped;
+  }
+  int32_t solved = 0;
+  for(sz_t b = 0; b < count; ++b)solved += out_results[b] == COMPLETE;
+  if(out_dropped != NULL)*out_dropped = dropped;
+  return solved;
+}
+
+/* ============================================================================
+ * GENERATOR (from sudoku_generator.c)
+ * ============================================================================ */
+
+typedef struct {
+  sz_t n, ne2, ne4;
+  sd_t *solver;
+  val_t *table;
+  RESULT status;
+  sz_t no_vals;
+} sdgen_t;
+
+static sdgen_t sdgen_init(sz_t n) {
+  sdgen_t s={.n=n,.ne2=n*n,.ne4=n*n*n*n,.solver=NULL,.table=malloc(sizeof(val_t)*n*n*n*n),
+    .status=MULTIPLE,.no_vals=0};
+  assert(s.table!=NULL),memset(s.table,0x00,sizeof(val_t)*s.ne4);
+  return s;
+}
+
+// Wall-clock milliseconds; clock() counts CPU time of the whole process, which
+// is meaningless as a timeout once several generators run in parallel.
+static int64_t sd_now_ms(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static void sdgen_free(sdgen_t *s){if(s->solver)free_sd(s->solver);free(s->table);}
+
+static void ord_arr(sz_t *arr, sz_t len){for(sz_t i=0;i<len;++i)arr[i]=i;}
+
+static void gen_shuffle_arr(sz_t *arr, sz_t len) {
+  for(sz_t i = 1; i < len; ++i) {
+    sz_t j = xorshift32()%i;
+    sz_t tmp;if(i!=j)tmp=arr[i],arr[i]=arr[j],arr[j]=tmp;
+  }
+}
+
+static void setboard_gen(sdgen_t *s) {
+  if(s->solver==NULL)s->solver=make_sd(s->n,s->table);
+  else memcpy(s->solver->table, s->table, sizeof(val_t) * s->ne4);
+}
 
 static RESULT solve_gen(sdgen_t *s) {
   setboard_gen(s);
@@ -608,6 +1774,257 @@ static void shift_arr(sz_t *arr, sz_t idx, sz_t *len) {
   --*len;
 }
 
+/* ============================================================================
+ * MINIMALITY
+ * ============================================================================ */
+
+#define MINIMAL_MAX_THREADS 16
+// nodes searched between deadline checks
+#define MINIMAL_SLICE 4096
+
+typedef struct {
+  const val_t *table, *solution;
+  sz_t n;
+  const sz_t *clues;
+  int32_t no_clues;
+  atomic_int next;
+  int64_t deadline;  // sd_now_ms() past which clues are left untested, 0 = none
+  val_t *redundant;  // per entry of clues
+} minimal_t;
+
+/*
+ * A clue can be removed iff the puzzle without it still has a unique solution.
+ * Any other solution would differ from the known one at that cell, or it would
+ * solve the full puzzle too. So instead of re-solving without the clue and
+ * counting to two, the known value is struck from the cell's candidates and
+ * the search stops at its first solution, which proves the clue necessary.
+ * The subtree holding the known solution is never entered, and the search is
+ * guided by the known solution (s->guide): a second solution usually differs
+ * from it in only a few cells, so it turns up early. A test still running at
+ * the deadline (0 = none) gives up and reports the clue necessary.
+ */
+static bool clue_redundant(sd_t *s, const val_t *table, const val_t *solution, sz_t cell, int64_t deadline) {
+  memcpy(s->table, table, sizeof(val_t) * s->ne4);
+  s->table[cell] = 0;
+  min_t m;
+  if(!sd_search_start(s, &m))return false;
+  // cover the row as sd_forward would, so no search step can uncover it
+  const sz_t r = cell * s->ne2 + solution[cell] - 1;
+  if(s->cov->row[r]++ == 0)
+    for(sz_t ic = 0; ic < NO_CONSTR; ++ic)--s->cov->col[C_CNSTR(r, ic)];
+  // starting from COMPLETE makes the first solution end the search
+  RESULT res = COMPLETE, found;
+  while((found = sd_search(s, &m, &res, deadline ? MINIMAL_SLICE : -1)) == RUNNING)
+    if(sd_now_ms() > deadline)return false;
+  return found != MULTIPLE;
+}
+
+static void *minimal_worker(void *arg) {
+  minimal_t *p = arg;
+  sd_t *s = make_sd(p->n, (val_t *)p->table);
+  s->guide = p->solution;
+  for(int32_t k; (k = atomic_fetch_add(&p->next, 1)) < p->no_clues;) {
+    if(p->deadline && sd_now_ms() > p->deadline)break;
+    p->redundant[k] = clue_redundant(s, p->table, p->solution, p->clues[k], p->deadline);
+  }
+  free_sd(s);
+  return NULL;
+}
+
+// Test clues[0..no_clues) of a puzzle whose unique solution is known, on up to
+// `threads` threads (<= 0 = online cores) with the caller taking part. Clues
+// not reached by the deadline (0 = none) count as necessary.
+static void find_redundant(const val_t *table, sz_t n, const val_t *solution, const sz_t *clues,
+                           int32_t no_clues, int32_t threads, int64_t deadline, val_t *out_redundant) {
+  if(threads <= 0)threads = (int32_t)sysconf(_SC_NPROCESSORS_ONLN);
+  if(threads > no_clues)threads = no_clues;
+  if(threads > MINIMAL_MAX_THREADS)threads = MINIMAL_MAX_THREADS;
+  if(threads < 1)threads = 1;
+  minimal_t p = {.table=table, .solution=solution, .n=n, .clues=clues, .no_clues=no_clues,
+    .deadline=deadline, .redundant=out_redundant};
+  memset(out_redundant, 0, sizeof(val_t) * no_clues);
+  atomic_init(&p.next, 0);
+  pthread_t tids[MINIMAL_MAX_THREADS];
+  bool started[MINIMAL_MAX_THREADS] = {false};
+  for(int32_t k = 1; k < threads; ++k)started[k] = pthread_create(&tids[k], NULL, minimal_worker, &p) == 0;
+  minimal_worker(&p);
+  for(int32_t k = 1; k < threads; ++k)if(started[k])pthread_join(tids[k], NULL);
+}
+
+/*
+ * Find the clues that can be removed while keeping the solution unique; a
+ * puzzle is minimal (irreducible) when there are none.
+ *
+ * Parameters:
+ *   table: puzzle values (0 = empty)
+ *   n: box size
+ *   threads: number of workers (<= 0 = online cores), at most MINIMAL_MAX_THREADS
+ *   out_redundant_mask: n^4 bits, bit i % 8 of byte i / 8 set when clue i is
+ *     removable on its own
+ *
+ * Returns: number of removable clues, or -1 if the puzzle has no unique
+ * solution (the mask is then left clear)
+ */
+int32_t check_minimal(const uint8_t *table, int32_t n, int32_t threads, uint8_t *out_redundant_mask) {
+  const sz_t ne4 = n * n * n * n;
+  memset(out_redundant_mask, 0x00, (ne4 + 7) / 8);
+  sd_t *s = make_sd(n, (val_t *)table);
+  RESULT res = solve_sd(s);
+  if(res != COMPLETE) {
+    free_sd(s);
+    return -1;
+  }
+  sz_t *clues = malloc(sizeof(sz_t) * ne4);assert(clues != NULL);
+  val_t *redundant = malloc(sizeof(val_t) * ne4);assert(redundant != NULL);
+  int32_t no_clues = 0, no_redundant = 0;
+  for(sz_t i = 0; i < ne4; ++i)if(table[i])clues[no_clues++] = i;
+  find_redundant(table, n, s->table, clues, no_clues, threads, 0, redundant);
+  for(int32_t k = 0; k < no_clues; ++k)
+    if(redundant[k])out_redundant_mask[clues[k] / 8] |= 1 << (clues[k] % 8), ++no_redundant;
+  free_sd(s);
+  free(clues),free(redundant);
+  return no_redundant;
+}
+
+/*
+ * Remove clues of a generator board until it has `target` clues or is
+ * minimal, stopping at the deadline (0 = none). The clues are tested in random
+ * order in rounds of one per thread, against the board as it is when the
+ * round starts, and a round removes every clue it finds redundant. Removing
+ * one can make another necessary, so each after the first is tested again
+ * before it goes. Removing a clue never makes another one removable, so every
+ * clue is tested about once and the board is minimal when all have been.
+ */
+static void reduce_to_minimal(sdgen_t *s, sz_t target, int64_t deadline, int32_t threads) {
+  if(threads <= 0)threads = (int32_t)sysconf(_SC_NPROCESSORS_ONLN);
+  if(threads > MINIMAL_MAX_THREADS)threads = MINIMAL_MAX_THREADS;
+  if(threads < 1)threads = 1;
+  setboard_gen(s);
+  if(solve_sd(s->solver) != COMPLETE)return;
+  val_t *solution = malloc(sizeof(val_t) * s->ne4);assert(solution != NULL);
+  memcpy(solution, s->solver->table, sizeof(val_t) * s->ne4);
+  sz_t *clues = malloc(sizeof(sz_t) * s->ne4);assert(clues != NULL);
+  val_t redundant[MINIMAL_MAX_THREADS];
+  int32_t no_clues = 0;
+  for(sz_t i = 0; i < s->ne4; ++i)if(s->table[i])clues[no_clues++] = i;
+  gen_shuffle_arr(clues, no_clues);
+  sd_t *check = NULL;
+  for(int32_t first = 0; first < no_clues && s->no_vals > target; first += threads) {
+    if(deadline && sd_now_ms() > deadline)break;
+    const int32_t len = no_clues - first < threads ? no_clues - first : threads;
+    find_redundant(s->table, s->n, solution, &clues[first], len, threads, deadline, redundant);
+    bool removed = false;
+    for(int32_t k = 0; k < len && s->no_vals > target; ++k) {
+      if(!redundant[k])continue;
+      if(removed) {
+        if(deadline && sd_now_ms() > deadline)break;
+        if(check == NULL)check = make_sd(s->n, s->table), check->guide = solution;
+        if(!clue_redundant(check, s->table, solution, clues[first + k], deadline))continue;
+      }
+      s->table[clues[first + k]] = 0, --s->no_vals, removed = true;
+    }
+  }
+  if(check != NULL)free_sd(check);
+  free(solution),free(clues);
+}
+
+/* ============================================================================
+ * SOLUTION GRIDS
+ * ============================================================================ */
+
+// Mixing moves per cell. Grid statistics such as the number of deadly
+// rectangles stop changing after about one move per cell for n=3..5.
+#define GRID_MIX_MOVES 2
+
+typedef struct {
+  sz_t n, ne2, ne4;
+  val_t *g;       // values 0..ne2-1
+  sz_t *unit;     // (cell * 3 + k) -> row, ne2 + column, 2 * ne2 + box
+  sz_t *pos;      // (unit * ne2 + value) -> cell
+  sz_t *stack;
+  bool *seen;
+} grid_t;
+
+static void grid_set(grid_t *m, sz_t cell, val_t v) {
+  m->g[cell] = v;
+  for(int k = 0; k < 3; ++k)m->pos[m->unit[cell * 3 + k] * m->ne2 + v] = cell;
+}
+
+// Swap values a and b on the component of x among the cells holding either,
+// two such cells being linked when they share a unit. Every unit meeting the
+// component holds both of its a and b cells, so the grid stays valid.
+static void grid_swap_values(grid_t *m) {
+  sz_t x = xorshift32() % m->ne4, len = 0;
+  val_t a = m->g[x], b = (a + 1 + xorshift32() % (m->ne2 - 1)) % m->ne2;
+  m->stack[len++] = x, m->seen[x] = true;
+  for(sz_t i = 0; i < len; ++i) {
+    sz_t y = m->stack[i];
+    val_t w = m->g[y] == a ? b : a;
+    for(int k = 0; k < 3; ++k) {
+      sz_t z = m->pos[m->unit[y * 3 + k] * m->ne2 + w];
+      if(!m->seen[z])m->seen[z] = true, m->stack[len++] = z;
+    }
+  }
+  for(sz_t i = 0; i < len; ++i) {
+    sz_t y = m->stack[i];
+    m->seen[y] = false, grid_set(m, y, m->g[y] == a ? b : a);
+  }
+}
+
+// Swap two rows of a band (axis 0) or two columns of a stack (axis 1) on the
+// cycle of positions through p0 along which each line's values are a
+// permutation of the other's. Boxes are preserved since both lines cross the
+// same boxes at every position.
+static void grid_swap_lines(grid_t *m, int axis) {
+  sz_t n = m->n, ne2 = m->ne2, band = xorshift32() % n, i = xorshift32() % n;
+  sz_t l1 = band * n + i, l2 = band * n + (i + 1 + xorshift32() % (n - 1)) % n;
+  sz_t p0 = xorshift32() % ne2, p = p0, len = 0;
+  // cell (line l, position p) is l * line_step + p * pos_step
+  const sz_t line_step = axis ? 1 : ne2, pos_step = axis ? ne2 : 1;
+  do {
+    m->stack[len++] = p;
+    sz_t z = m->pos[(axis * ne2 + l1) * ne2 + m->g[l2 * line_step + p * pos_step]];
+    p = m->unit[z * 3 + 1 - axis] - (axis ? 0 : ne2);
+  } while(p != p0);
+  for(sz_t k = 0; k < len; ++k) {
+    sz_t c1 = l1 * line_step + m->stack[k] * pos_step, c2 = l2 * line_step + m->stack[k] * pos_step;
+    val_t v1 = m->g[c1];
+    grid_set(m, c1, m->g[c2]), grid_set(m, c2, v1);
+  }
+}
+
+/*
+ * Random solution grid with values 1..n^2, drawn from the thread's xorshift
+ * stream. No search is involved, so this always succeeds: the pattern grid
+ * (n*(r%n) + r/n + c) mod n^2 is put through apply_isomorphism and then
+ * GRID_MIX_MOVES * n^4 random value swaps and row or column swaps, each of
+ * which maps a valid grid to a valid grid. apply_isomorphism reseeds the
+ * stream from a value drawn off it, which keeps the result reproducible.
+ * For n = 1 there is nothing to swap and the grid is just the pattern.
+ */
+static void sample_grid(val_t *out, sz_t n) {
+  sz_t ne2 = n * n, ne4 = ne2 * ne2;
+  val_t *tmp = malloc(sizeof(val_t) * ne4);
+  grid_t m = {.n=n, .ne2=ne2, .ne4=ne4, .g=out, .unit=malloc(sizeof(sz_t) * 3 * ne4),
+    .pos=malloc(sizeof(sz_t) * 3 * ne4), .stack=malloc(sizeof(sz_t) * 2 * ne2),
+    .seen=calloc(ne4, sizeof(bool))};
+  assert(tmp != NULL && m.unit != NULL && m.pos != NULL && m.stack != NULL && m.seen != NULL);
+  for(sz_t r = 0; r < ne2; ++r)for(sz_t c = 0; c < ne2; ++c) {
+    sz_t *u = &m.unit[(r * ne2 + c) * 3];
+    u[0] = r, u[1] = ne2 + c, u[2] = 2 * ne2 + (r / n) * n + c / n;
+    tmp[r * ne2 + c] = (n * (r % n) + r / n + c) % ne2 + 1;
+  }
+  apply_isomorphism(tmp, out, n, xorshift32() | 1);
+  for(sz_t i = 0; i < ne4; ++i)grid_set(&m, i, out[i] - 1);
+  for(sz_t k = n < 2 ? 0 : GRID_MIX_MOVES * ne4; k > 0; --k) {
+    uint32_t move = xorshift32() % 3;
+    if(move == 2)grid_swap_values(&m);
+    else grid_swap_lines(&m, move);
+  }
+  for(sz_t i = 0; i < ne4; ++i)++out[i];
+  free(tmp),free(m.unit),free(m.pos),free(m.stack),free(m.seen);
+}
+
 /*
  * Generate a new puzzle.
  *
@@ -617,34 +2034,27 @@ static void shift_arr(sz_t *arr, sz_t idx, sz_t *len) {
  *   seed: random seed
  *   difficulty: 0.0 = many hints (easiest), 1.0 = fully reduced (hardest)
  *   timeout_ms: max generation time in milliseconds (0 = no limit)
+ *   flags: SD_GENERATE_MINIMAL to stop the removal loop halfway through
+ *     timeout_ms and spend the rest in reduce_to_minimal, which tests clues in
+ *     parallel, until the puzzle reaches the target, is verified minimal or
+ *     the timeout ends
+ *   threads: workers for SD_GENERATE_MINIMAL (<= 0 = online cores); callers
+ *     that already generate on several threads pass 1
  *
- * Returns: number of hints in generated puzzle
+ * Returns: number of hints in generated puzzle, 0 with an empty table for n < 2
  */
-int32_t generate_puzzle(uint8_t *out_table, int32_t n, uint32_t seed, float difficulty, int32_t timeout_ms) {
-  xorshift_state = seed ? seed : (uint32_t)time(NULL);
+#define SD_GENERATE_MINIMAL 0x1
 
-  sdgen_t s = sdgen_init(n);
-
-  // For small grids (n=2), diagonal box filling may create unsolvable puzzles.
-  // Retry with different seeds until we get a solvable configuration.
-  int max_retries = 100;
-  for(int retry = 0; retry < max_retries; ++retry) {
-    memset(s.table, 0, sizeof(val_t) * s.ne4);
-    s.no_vals = 0;
-    sd_init_diagonal_boxes(&s);
-    setboard_gen(&s);
-    s.status = solve_sd(s.solver);
-    if(s.status != INVALID) break;
-    xorshift_state += 1;  // try different seed
-  }
-  if(s.status == INVALID) {
-    // Couldn't find solvable configuration, return empty
-    memset(out_table, 0, sizeof(val_t) * s.ne4);
-    sdgen_free(&s);
+int32_t generate_puzzle(uint8_t *out_table, int32_t n, uint32_t seed, float difficulty, int32_t timeout_ms,
+                        int32_t flags, int32_t threads) {
+  if(n < 2) {
+    if(n == 1)out_table[0] = 0;
     return 0;
   }
-  // Copy solution to table
-  for(sz_t i=0;i<s.ne4;++i)s.table[i]=s.solver->table[i];
+  xorshift_state = seed ? seed : (uint32_t)time(NULL);
+
+  sdgen_t s = sdgen_init(n);
+  sample_grid(s.table, n);
   s.no_vals=s.ne4;
 
   sz_t len = s.ne4;
@@ -666,15 +2076,20 @@ int32_t generate_puzzle(uint8_t *out_table, int32_t n, uint32_t seed, float diff
   sz_t target_hints = (sz_t)(min_hints * powf(ratio, 1.0f - difficulty));
   if(difficulty <= 0.01f)target_hints = s.ne4;  // keep everything
 
-  clock_t start = clock();
-  clock_t timeout_clocks = timeout_ms ? (timeout_ms * CLOCKS_PER_SEC / 1000) : 0;
+  const int64_t start = sd_now_ms();
+  const bool minimal = (flags & SD_GENERATE_MINIMAL) && timeout_ms;
+  const int32_t serial_ms = minimal ? timeout_ms / 2 : timeout_ms;
+  bool timed_out = false;
 
   while(s.no_vals > target_hints) {
     gen_shuffle_arr(arr, len);
     sz_t prev_len = len;
 
     for(sz_t i = 0; i < len && s.no_vals > target_hints; ++i) {
-      if(timeout_clocks && (clock() - start) > timeout_clocks)goto endgen;
+      if(timeout_ms && sd_now_ms() - start > serial_ms) {
+        timed_out = true;
+        goto endgen;
+      }
       if(try_unset(&s, arr[i]))shift_arr(arr, i--, &len);
     }
 
@@ -682,6 +2097,9 @@ int32_t generate_puzzle(uint8_t *out_table, int32_t n, uint32_t seed, float diff
   }
 
 endgen:;
+  // a full pass without removals already proves the puzzle minimal, so only a
+  // timeout leaves anything to do
+  if(minimal && timed_out && s.no_vals > target_hints)reduce_to_minimal(&s, target_hints, start + timeout_ms, threads);
   // Relabel values randomly
   sz_t *rename = malloc(sizeof(sz_t) * s.ne2);
   ord_arr(rename, s.ne2),gen_shuffle_arr(rename, s.ne2);
@@ -697,6 +2115,448 @@ endgen:;
   return num_hints;
 }
 
+/* ============================================================================
+ * CANONICAL FORM
+ * ============================================================================ */
+
+// Upper bound on the column arrangements enumerated per puzzle. Past it (n>=4)
+// columns within stacks keep their order and the grid is not transposed.
+#define CANON_MAX_TRANSFORMS 4096
+
+static sz_t factorial(sz_t n){sz_t f=1;for(sz_t i=2;i<=n;++i)f*=i;return f;}
+
+// All permutations of 0..n-1 in lexicographic order, n! rows of n entries.
+static sz_t *make_perms(sz_t n) {
+  sz_t nf = factorial(n);
+  sz_t *perms = malloc(sizeof(sz_t) * nf * n);assert(perms != NULL);
+  sz_t *p = perms;
+  ord_arr(p, n);
+  for(sz_t k = 1; k < nf; ++k) {
+    memcpy(p + n, p, sizeof(sz_t) * n), p += n;
+    sz_t i = n - 2;
+    while(p[i] > p[i + 1])--i;
+    sz_t j = n - 1;
+    while(p[j] < p[i])--j;
+    sz_t tmp=p[i];p[i]=p[j],p[j]=tmp;
+    for(sz_t a = i + 1, b = n - 1; a < b; ++a, --b)tmp=p[a],p[a]=p[b],p[b]=tmp;
+  }
+  return perms;
+}
+
+typedef struct {
+  sz_t n, ne2;
+  const val_t *table;
+  const sz_t *colmap;  // source column of each output column
+  bool transpose;
+  val_t *best;        // smallest grid so far, valid in its first best_rows rows
+  sz_t best_rows;
+  val_t label[UCHAR_MAX + 1];
+  sz_t band_of[UCHAR_MAX + 1];  // source band of each output band
+  bool *row_used, *band_used;
+  val_t *rows;  // smallest candidate row per output row
+  sz_t *ties;   // source rows reaching it
+  // earlier row of the band, or band, with the same cells; UNDEF_SIZE if none
+  sz_t *row_twin, *band_twin;
+} canon_t;
+
+// Fill row_twin and band_twin for the grid as read under k->transpose.
+static void canon_twins(const canon_t *k, sz_t *row_twin, sz_t *band_twin) {
+  const sz_t n = k->n, ne2 = k->ne2;
+  #define CANON_CELL(r, c) (k->transpose ? k->table[(c) * ne2 + (r)] : k->table[(r) * ne2 + (c)])
+  for(sz_t r = 0; r < ne2; ++r) {
+    row_twin[r] = UNDEF_SIZE;
+    for(sz_t r2 = r; r2-- > r / n * n && row_twin[r] == UNDEF_SIZE;) {
+      sz_t c = 0;
+      while(c < ne2 && CANON_CELL(r, c) == CANON_CELL(r2, c))++c;
+      if(c == ne2)row_twin[r] = r2;
+    }
+  }
+  for(sz_t b = 0; b < n; ++b) {
+    band_twin[b] = UNDEF_SIZE;
+    for(sz_t b2 = b; b2-- > 0 && band_twin[b] == UNDEF_SIZE;) {
+      sz_t i = 0;
+      while(i < n * ne2 && CANON_CELL(b * n + i / ne2, i % ne2) == CANON_CELL(b2 * n + i / ne2, i % ne2))++i;
+      if(i == n * ne2)band_twin[b] = b2;
+    }
+  }
+  #undef CANON_CELL
+}
+
+// Relabel source row r into row, stopping early if it is larger than bound
+// (when given). Returns the comparison with bound; labels of new values are
+// left in k->label, listed in added.
+static int canon_relabel(canon_t *k, sz_t r, val_t next, const val_t *bound, val_t *row,
+                         val_t *added, sz_t *no_added) {
+  const sz_t ne2 = k->ne2;
+  int cmp = bound ? 0 : -1;
+  *no_added = 0;
+  for(sz_t c = 0; c < ne2 && cmp <= 0; ++c) {
+    const sz_t sc = k->colmap[c];
+    val_t v = k->transpose ? k->table[sc * ne2 + r] : k->table[r * ne2 + sc];
+    if(v && !k->label[v])k->label[v] = next++, added[(*no_added)++] = v;
+    row[c] = k->label[v];
+    if(cmp == 0)cmp = (row[c] > bound[c]) - (row[c] < bound[c]);
+  }
+  return cmp;
+}
+
+// Whether source row r may follow at output row d: its band is unused (or the
+// band of output row d's band), and no identical earlier band or row is unused.
+static bool canon_row_allowed(const canon_t *k, sz_t d, sz_t r) {
+  const sz_t n = k->n, sb = r / n;
+  if(d % n == 0 ? k->band_used[sb] || (k->band_twin[sb] != UNDEF_SIZE && !k->band_used[k->band_twin[sb]])
+                : sb != k->band_of[d / n])return false;
+  return !k->row_used[r] && (k->row_twin[r] == UNDEF_SIZE || k->row_used[k->row_twin[r]]);
+}
+
+/*
+ * Choose the source rows of output rows d.. so that the relabeled grid is
+ * smallest, values being labeled in order of first appearance. Only the
+ * candidates whose relabeled row is the smallest at row d are followed, and
+ * none if that row is larger than the best grid's row d, whose earlier rows
+ * the current ones match (candidates are cut off against it while relabeling);
+ * a smaller one replaces the best grid from row d on.
+ * Of identical rows within a band, and of identical bands, only the first
+ * unused one is tried, since the others lead to the same grids.
+ */
+static void canon_rows(canon_t *k, sz_t d, val_t next_label) {
+  const sz_t ne2 = k->ne2;
+  if(d == ne2)return;
+  val_t *min = &k->rows[d * ne2], *out = &k->best[d * ne2], row[UCHAR_MAX + 1], added[UCHAR_MAX + 1];
+  sz_t *ties = &k->ties[d * ne2], no_ties = 0, no_added;
+  for(sz_t r = 0; r < ne2; ++r) {
+    if(!canon_row_allowed(k, d, r))continue;
+    const val_t *bound = no_ties ? min : d < k->best_rows ? out : NULL;
+    int cmp = canon_relabel(k, r, next_label, bound, row, added, &no_added);
+    while(no_added)k->label[added[--no_added]] = 0;
+    if(cmp > 0)continue;
+    if(cmp < 0 || !no_ties)memcpy(min, row, ne2), no_ties = 0;
+    ties[no_ties++] = r;
+  }
+  if(no_ties == 0)return;
+  int cmp = d < k->best_rows ? memcmp(min, out, ne2) : -1;
+  if(cmp > 0)return;
+  if(cmp < 0)memcpy(out, min, ne2), k->best_rows = d + 1;
+  for(sz_t i = 0; i < no_ties; ++i) {
+    const sz_t r = ties[i], sb = r / k->n;
+    canon_relabel(k, r, next_label, NULL, row, added, &no_added);
+    const val_t next = next_label + no_added;
+    if(d % k->n == 0)k->band_used[sb] = true, k->band_of[d / k->n] = sb;
+    k->row_used[r] = true;
+    canon_rows(k, d + 1, next);
+    k->row_used[r] = false;
+    if(d % k->n == 0)k->band_used[sb] = false;
+    while(no_added)k->label[added[--no_added]] = 0;
+  }
+}
+
+/*
+ * Hash of the lexicographically smallest isomorph of a puzzle.
+ *
+ * The isomorphs are those under value relabeling, transposition, band and
+ * stack permutations, and row and column permutations within bands and
+ * stacks. Every column arrangement (with or without transposition) is
+ * enumerated, and for each the rows are chosen one at a time, following only
+ * the candidates that give the smallest next row (canon_rows). Two puzzles get the same hash iff they are isomorphic, up to a
+ * 64-bit collision. For n>=4 there are too many column arrangements, so
+ * only relabeling, band and stack permutations and rows within bands are
+ * covered; transposing alone would then not give a group, as it swaps the
+ * roles of rows and columns.
+ */
+uint64_t canonical_hash(const uint8_t *table, int32_t n) {
+  const sz_t ne2 = n * n, ne4 = ne2 * ne2, nf = factorial(n);
+  sz_t *perms = make_perms(n);
+  // odometer digits: transpose, stack perm, n column perms
+  const sz_t ndigits = 2 + n;
+  sz_t *radix = malloc(sizeof(sz_t) * ndigits), *digit = calloc(ndigits, sizeof(sz_t));
+  assert(radix != NULL && digit != NULL);
+  const bool full = 2.0 * pow((double)nf, 1.0 + n) <= CANON_MAX_TRANSFORMS;
+  radix[0] = full ? 2 : 1, radix[1] = nf;
+  for(sz_t i = 2; i < ndigits; ++i)radix[i] = full ? nf : 1;
+  sz_t *colmap = malloc(sizeof(sz_t) * ne2);
+  canon_t k = {.n=n, .ne2=ne2, .table=table, .colmap=colmap, .best=malloc(sizeof(val_t) * ne4), .best_rows=0,
+    .label={0}, .row_used=calloc(ne2, sizeof(bool)), .band_used=calloc(n, sizeof(bool)),
+    .rows=malloc(sizeof(val_t) * ne4), .ties=malloc(sizeof(sz_t) * ne4), .row_twin=NULL, .band_twin=NULL};
+  sz_t *row_twins = malloc(sizeof(sz_t) * 2 * ne2), *band_twins = malloc(sizeof(sz_t) * 2 * n);
+  assert(colmap != NULL && k.best != NULL && k.row_used != NULL && k.band_used != NULL
+         && k.rows != NULL && k.ties != NULL
+         && row_twins != NULL && band_twins != NULL);
+  for(sz_t t = 0; t < radix[0]; ++t)k.transpose = t, canon_twins(&k, &row_twins[t * ne2], &band_twins[t * n]);
+  while(1) {
+    const sz_t *sp = &perms[digit[1] * n];
+    for(sz_t b = 0; b < n; ++b) {
+      const sz_t *cp = &perms[digit[2 + sp[b]] * n];
+      for(sz_t i = 0; i < n; ++i)colmap[b * n + i] = sp[b] * n + cp[i];
+    }
+    k.transpose = digit[0], k.row_twin = &row_twins[digit[0] * ne2], k.band_twin = &band_twins[digit[0] * n];
+    canon_rows(&k, 0, 1);
+    sz_t d = 0;
+    while(d < ndigits && ++digit[d] == radix[d])digit[d++] = 0;
+    if(d == ndigits)break;
+  }
+  uint64_t hash = 0xcbf29ce484222325ULL ^ (uint64_t)n;
+  for(sz_t i = 0; i < ne4; ++i)hash ^= k.best[i], hash *= 0x100000001b3ULL;
+  free(perms),free(radix),free(digit),free(colmap);
+  free(k.best),free(k.row_used),free(k.band_used),free(k.rows),free(k.ties),free(row_twins),free(band_twins);
+  return hash;
+}
+
+/* ============================================================================
+ * PROPAGATION SESSION
+ * ============================================================================ */
+
+/*
+ * Candidate state of a board being played, updated move by move. Each cell
+ * holds a bitset of its candidates (bit v-1 for value v). Assigning or
+ * eliminating a candidate propagates naked singles (a cell left with one
+ * candidate takes it) and hidden singles (a value left with one cell in a row,
+ * column or box goes there) until nothing changes or a cell or unit runs out
+ * of candidates.
+ *
+ * Every change is recorded on a trail together with what it overwrote, so
+ * undoing a move costs as much as the move did, whatever the length of the
+ * game. Undone moves can be redone until a new move is made.
+ */
+#define SESSION_MAX_N 8
+typedef uint64_t cand_t;
+
+typedef enum { MOVE_ASSIGN, MOVE_ELIMINATE } MOVE;
+
+typedef struct {
+  int32_t cell;
+  val_t value;
+  cand_t cand;
+} trail_t;
+
+typedef struct {
+  sz_t trail_len;
+  bool conflict;
+  MOVE kind;
+  int32_t cell;
+  val_t value;
+} move_t;
+
+typedef struct {
+  sz_t n, ne2, ne4;
+  val_t *values;    // placed value per cell, 0 if open
+  cand_t *cand;     // candidates per cell, shared with the caller
+  uint8_t *count;   // per unit and value: cells of the unit that can hold it
+  int32_t *units;   // 3 per cell: its row, column and box
+  int32_t *unit_cells;
+  bool conflict;
+  // changes, and the trail length before each move
+  trail_t *trail;
+  sz_t trail_len, trail_cap;
+  move_t *moves;
+  sz_t moves_len, moves_cap, redo_len;
+  // pending singles: cell << 8 | 0xff for a naked single, unit << 8 | bit for a hidden one
+  int32_t *queue;
+  sz_t queue_len, queue_cap;
+} session_t;
+
+#define SESSION_NAKED 0xff
+
+static inline void session_push(session_t *p, int32_t item) {
+  if(p->queue_len == p->queue_cap)
+    p->queue_cap *= 2, p->queue = realloc(p->queue, sizeof(int32_t) * p->queue_cap),assert(p->queue != NULL);
+  p->queue[p->queue_len++] = item;
+}
+
+// Narrow the candidates of a cell, recording the old state on the trail.
+static void session_restrict(session_t *p, sz_t cell, cand_t cand) {
+  const cand_t removed = p->cand[cell] & ~cand;
+  if(!removed)return;
+  if(p->trail_len == p->trail_cap)
+    p->trail_cap *= 2, p->trail = realloc(p->trail, sizeof(trail_t) * p->trail_cap),assert(p->trail != NULL);
+  p->trail[p->trail_len++] = (trail_t){.cell=(int32_t)cell, .value=p->values[cell], .cand=p->cand[cell]};
+  p->cand[cell] &= cand;
+  for(cand_t bits = removed; bits; bits &= bits - 1) {
+    const sz_t b = __builtin_ctzll(bits);
+    for(sz_t k = 0; k < 3; ++k) {
+      const sz_t u = p->units[cell * 3 + k];
+      const uint8_t left = --p->count[u * p->ne2 + b];
+      if(left == 0)p->conflict = true;
+      else if(left == 1)session_push(p, (int32_t)(u << 8 | b));
+    }
+  }
+  if(p->cand[cell] == 0)p->conflict = true;
+  else if(!p->values[cell] && !(p->cand[cell] & (p->cand[cell] - 1)))session_push(p, (int32_t)(cell << 8 | SESSION_NAKED));
+}
+
+static void session_propagate(session_t *p) {
+  while(p->queue_len > 0 && !p->conflict) {
+    const int32_t item = p->queue[--p->queue_len];
+    const sz_t b = item & 0xff;
+    if(b == SESSION_NAKED) {
+      const sz_t cell = item >> 8;
+      if(p->values[cell] || !p->cand[cell] || (p->cand[cell] & (p->cand[cell] - 1)))continue;
+      const cand_t bit = p->cand[cell];
+      // the value change rides on a trail entry that leaves cand as it is
+      if(p->trail_len == p->trail_cap)
+        p->trail_cap *= 2, p->trail = realloc(p->trail, sizeof(trail_t) * p->trail_cap),assert(p->trail != NULL);
+      p->trail[p->trail_len++] = (trail_t){.cell=(int32_t)cell, .value=0, .cand=bit};
+      p->values[cell] = __builtin_ctzll(bit) + 1;
+      for(sz_t k = 0; k < 3; ++k) {
+        const int32_t *uc = &p->unit_cells[p->units[cell * 3 + k] * p->ne2];
+        for(sz_t j = 0; j < p->ne2; ++j)if(uc[j] != cell)session_restrict(p, uc[j], ~bit);
+      }
+    } else {
+      const sz_t u = item >> 8;
+      if(p->count[u * p->ne2 + b] != 1)continue;
+      const int32_t *uc = &p->unit_cells[u * p->ne2];
+      for(sz_t j = 0; j < p->ne2; ++j)
+        if(p->cand[uc[j]] & ((cand_t)1 << b)){session_restrict(p, uc[j], (cand_t)1 << b);break;}
+    }
+  }
+  p->queue_len = 0;
+}
+
+static void session_undo_to(session_t *p, sz_t trail_len) {
+  while(p->trail_len > trail_len) {
+    const trail_t *t = &p->trail[--p->trail_len];
+    for(cand_t bits = t->cand & ~p->cand[t->cell]; bits; bits &= bits - 1) {
+      const sz_t b = __builtin_ctzll(bits);
+      for(sz_t k = 0; k < 3; ++k)++p->count[p->units[t->cell * 3 + k] * p->ne2 + b];
+    }
+    p->cand[t->cell] = t->cand, p->values[t->cell] = t->value;
+  }
+}
+
+static bool session_apply(session_t *p, MOVE kind, sz_t cell, val_t value) {
+  if(p->moves_len == p->moves_cap)
+    p->moves_cap *= 2, p->moves = realloc(p->moves, sizeof(move_t) * p->moves_cap),assert(p->moves != NULL);
+  p->moves[p->moves_len++] = (move_t){.trail_len=p->trail_len, .conflict=p->conflict,
+    .kind=kind, .cell=(int32_t)cell, .value=value};
+  const cand_t bit = (cand_t)1 << (value - 1);
+  session_restrict(p, cell, kind == MOVE_ASSIGN ? bit : ~bit);
+  session_propagate(p);
+  return !p->conflict;
+}
+
+/*
+ * Apply one move and propagate. Returns false if the board is now in
+ * conflict; the state is kept so that it can be shown, and undone.
+ */
+static bool session_move(session_t *p, MOVE kind, sz_t cell, val_t value) {
+  p->redo_len = 0;
+  return session_apply(p, kind, cell, value);
+}
+
+static bool session_undo(session_t *p) {
+  if(p->moves_len == 0)return false;
+  const move_t *mv = &p->moves[--p->moves_len];
+  session_undo_to(p, mv->trail_len);
+  p->conflict = mv->conflict;
+  ++p->redo_len;
+  return true;
+}
+
+static bool session_redo(session_t *p) {
+  if(p->redo_len == 0)return false;
+  const move_t mv = p->moves[p->moves_len];
+  --p->redo_len;
+  session_apply(p, mv.kind, mv.cell, mv.value);
+  return true;
+}
+
+static void free_session(session_t *p) {
+  free(p->values), free(p->cand), free(p->count), free(p->units), free(p->unit_cells);
+  free(p->trail), free(p->moves), free(p->queue);
+  free(p);
+}
+
+// NULL if n is out of range or the givens conflict.
+static session_t *make_session(const val_t *table, sz_t n) {
+  if(n < 2 || n > SESSION_MAX_N)return NULL;
+  session_t *p = calloc(1, sizeof(session_t));assert(p != NULL);
+  p->n=n, p->ne2=n*n, p->ne4=p->ne2*p->ne2;
+  p->values=calloc(p->ne4, sizeof(val_t)),assert(p->values != NULL);
+  p->cand=malloc(sizeof(cand_t)*p->ne4),assert(p->cand != NULL);
+  p->count=malloc(sizeof(uint8_t)*3*p->ne2*p->ne2),assert(p->count != NULL);
+  p->units=malloc(sizeof(int32_t)*3*p->ne4),assert(p->units != NULL);
+  p->unit_cells=malloc(sizeof(int32_t)*3*p->ne4),assert(p->unit_cells != NULL);
+  p->trail_cap=p->ne4, p->trail=malloc(sizeof(trail_t)*p->trail_cap),assert(p->trail != NULL);
+  p->moves_cap=p->ne4, p->moves=malloc(sizeof(move_t)*p->moves_cap),assert(p->moves != NULL);
+  p->queue_cap=p->ne4, p->queue=malloc(sizeof(int32_t)*p->queue_cap),assert(p->queue != NULL);
+  const cand_t all = p->ne2 == 64 ? ~(cand_t)0 : ((cand_t)1 << p->ne2) - 1;
+  for(sz_t i = 0; i < p->ne4; ++i)p->cand[i] = all;
+  memset(p->count, p->ne2, sizeof(uint8_t)*3*p->ne2*p->ne2);
+  sz_t fill[3 * SESSION_MAX_N * SESSION_MAX_N] = {0};
+  for(sz_t i = 0; i < p->ne4; ++i) {
+    const sz_t r = i / p->ne2, c = i % p->ne2;
+    const sz_t u[3] = {r, p->ne2 + c, 2 * p->ne2 + r / n * n + c / n};
+    for(sz_t k = 0; k < 3; ++k)
+      p->units[i * 3 + k] = u[k], p->unit_cells[u[k] * p->ne2 + fill[u[k]]++] = i;
+  }
+  for(sz_t i = 0; i < p->ne4 && !p->conflict; ++i) {
+    if(table[i] > p->ne2){p->conflict = true;break;}
+    if(table[i])session_restrict(p, i, (cand_t)1 << (table[i] - 1)), session_propagate(p);
+  }
+  if(p->conflict){free_session(p);return NULL;}
+  // the givens are the starting point, not moves
+  p->trail_len = 0;
+  return p;
+}
+
+/* ============================================================================
+ * WARMUP
+ * ============================================================================ */
+
+#define SD_WARMUP_TOPOLOGY 0x1
+#define SD_WARMUP_GENERATE 0x2
+
+// Generated levels offered by the menu; see MenuScreen and Sudoku._setupSudoku.
+static const struct { int32_t n; float difficulty; int32_t timeout_ms; } pregen_levels[] = {
+  {3, 1.0f, 10000}, {4, 0.5f, 30000}, {4, 1.0f, 30000},
+};
+#define NO_PREGEN_LEVELS ((sz_t)(sizeof(pregen_levels) / sizeof(pregen_levels[0])))
+static pthread_mutex_t pregen_mtx = PTHREAD_MUTEX_INITIALIZER;
+static struct { val_t *table; int32_t hints; } pregen[NO_PREGEN_LEVELS];
+
+/*
+ * Prepare the library ahead of the first request; meant to run on a
+ * background thread at application startup.
+ *
+ * SD_WARMUP_TOPOLOGY builds the shared solver tables for n=2..4 and
+ * SD_WARMUP_GENERATE generates one puzzle per menu level, which the next
+ * take_pregenerated call for that level hands out.
+ */
+void warmup(int32_t flags) {
+  if(flags & SD_WARMUP_TOPOLOGY) {
+    for(sz_t n = 2; n <= 4; ++n) {
+      sd_t s = {.n=n, .ne2=n*n, .ne3=n*n*n, .ne4=n*n*n*n};
+      s.w = s.ne4 * NO_CONSTR, s.h = s.ne4 * s.ne2;
+      sd_attach_topology(&s);
+    }
+  }
+  if(flags & SD_WARMUP_GENERATE) {
+    uint32_t seed = (uint32_t)time(NULL);
+    for(sz_t i = 0; i < NO_PREGEN_LEVELS; ++i) {
+      int32_t n = pregen_levels[i].n;
+      val_t *table = malloc(sizeof(val_t) * n * n * n * n);assert(table != NULL);
+      int32_t hints = generate_puzzle(table, n, seed + i, pregen_levels[i].difficulty, pregen_levels[i].timeout_ms, 0, 1);
+      pthread_mutex_lock(&pregen_mtx);
+      if(pregen[i].table == NULL && hints > 0)pregen[i].table = table, pregen[i].hints = hints, table = NULL;
+      pthread_mutex_unlock(&pregen_mtx);
+      free(table);
+    }
+  }
+}
+
+// Hand out the puzzle generated by warmup for this level, if there is one.
+static bool take_pregenerated(uint8_t *out_table, int32_t n, float difficulty, int32_t *out_hints) {
+  bool found = false;
+  pthread_mutex_lock(&pregen_mtx);
+  for(sz_t i = 0; i < NO_PREGEN_LEVELS && !found; ++i) {
+    if(pregen_levels[i].n != n || pregen_levels[i].difficulty != difficulty || pregen[i].table == NULL)continue;
+    memcpy(out_table, pregen[i].table, sizeof(val_t) * n * n * n * n), *out_hints = pregen[i].hints;
+    free(pregen[i].table), pregen[i].table = NULL;
+    found = true;
+  }
+  pthread_mutex_unlock(&pregen_mtx);
+  return found;
+}
+
 /* ============================================================================
  * FFI EXPORTS
  * ============================================================================ */
@@ -709,7 +2569,18 @@ endgen:;
 #endif
 
 EXPORT int32_t sd_generate(uint8_t *out_table, int32_t n, uint32_t seed, float difficulty, int32_t timeout_ms) {
-  return generate_puzzle(out_table, n, seed, difficulty, timeout_ms);
+  return generate_puzzle(out_table, n, seed, difficulty, timeout_ms, 0, 1);
+}
+
+// Returns the hint count of the puzzle sd_warmup generated for this level, or
+// 0 if there is none (not warmed up, not a menu level, or already taken).
+EXPORT int32_t sd_take_pregenerated(uint8_t *out_table, int32_t n, float difficulty) {
+  int32_t hints;
+  return take_pregenerated(out_table, n, difficulty, &hints) ? hints : 0;
+}
+
+EXPORT void sd_warmup(int32_t flags) {
+  warmup(flags);
 }
 
 EXPORT int sd_difficulty(const uint8_t *table, int32_t n, int32_t num_samples, uint32_t seed,
@@ -728,6 +2599,122 @@ EXPORT int sd_difficulty(const uint8_t *table, int32_t n, int32_t num_samples, u
   return result;
 }
 
+EXPORT uint64_t sd_canonical_hash(const uint8_t *table, int32_t n) {
+  return canonical_hash(table, n);
+}
+
+EXPORT int32_t sd_check_minimal(const uint8_t *table, int32_t n, uint8_t *out_redundant_mask) {
+  return check_minimal(table, n, 0, out_redundant_mask);
+}
+
+// The batch calls return -1 without touching out_codes/out_results if count < 0.
+EXPORT int32_t sd_validate_batch(const uint8_t *boards, int32_t n, int32_t count, uint8_t *out_codes) {
+  if(count < 0)return -1;
+  return validate_batch(boards, n, count, out_codes);
+}
+
+EXPORT int32_t sd_solve_batch(uint8_t *boards, int32_t n, int32_t count, uint8_t *out_results) {
+  if(count < 0)return -1;
+  return solve_batch(boards, n, count, out_results, NULL);
+}
+
+/*
+ * Solve with a chosen branching strategy (HEURISTIC, optionally | ORDER_LCV
+ * and | SEARCH_LEARN); seed drives random tie-breaking. Reports the strategy
+ * actually used and the search effort.
+ */
+EXPORT int sd_solve_strategy(uint8_t *table, int32_t n, int32_t strategy, uint32_t seed,
+                             int32_t *out_strategy, int32_t *out_forwards, int32_t *out_backtracks) {
+  sd_t *s = make_sd(n, table);
+  sd_set_strategy(s, strategy, seed);
+  RESULT res = solve_sd(s);
+  if(res == COMPLETE)memcpy(table, s->table, sizeof(val_t) * s->ne4);
+  *out_strategy = s->heuristic | (s->lcv ? ORDER_LCV : 0) | (s->learn != NULL ? SEARCH_LEARN : 0);
+  *out_forwards = (int32_t)s->forward_count;
+  *out_backtracks = (int32_t)s->backtrack_count;
+  free_sd(s);
+  return (int)res;
+}
+
+EXPORT int sd_solve_portfolio(uint8_t *table, int32_t n, int32_t threads, uint32_t seed, int32_t *out_winner) {
+  return (int)solve_portfolio(table, n, threads, seed, out_winner);
+}
+
+/*
+ * Resumable solve; see STEPPED SOLVING. sd_solve_begin copies the puzzle.
+ * sd_solve_step runs at most max_nodes (>= 1) search nodes and returns
+ * RUNNING (3) until the result is known, then that result on every call.
+ * sd_solve_end frees the handle, first copying the solution to out_table
+ * (if not NULL) when the result is COMPLETE.
+ */
+EXPORT void *sd_solve_begin(const uint8_t *table, int32_t n) {
+  return make_solve_task((val_t *)table, n);
+}
+
+EXPORT int sd_solve_step(void *handle, int32_t max_nodes) {
+  return (int)solve_task_step(handle, max_nodes < 1 ? 1 : max_nodes);
+}
+
+EXPORT int32_t sd_solve_forwards(void *handle) {
+  return (int32_t)((solve_task_t *)handle)->s->forward_count;
+}
+
+EXPORT void sd_solve_end(void *handle, uint8_t *out_table) {
+  solve_task_t *t = handle;
+  if(t == NULL)return;
+  if(out_table != NULL && t->status == COMPLETE)memcpy(out_table, t->s->table, sizeof(val_t) * t->s->ne4);
+  free_solve_task(t);
+}
+
+/*
+ * Incremental candidate tracking for a board in play; see PROPAGATION SESSION.
+ * sd_session_new returns NULL if n > SESSION_MAX_N or the givens conflict.
+ * sd_session_candidates points at n^4 bitsets (bit v-1 for value v) and
+ * sd_session_values at n^4 placed values; both are updated in place by every
+ * call and stay valid until sd_session_free. Moves return 1, 0 if the board
+ * is left in conflict, or -1 for an out-of-range cell or value; undo and redo
+ * return 0 when there is nothing to undo or redo.
+ */
+EXPORT void *sd_session_new(const uint8_t *table, int32_t n) {
+  return make_session(table, n);
+}
+
+EXPORT int32_t sd_session_assign(void *session, int32_t cell, int32_t value) {
+  session_t *p = session;
+  if(cell < 0 || cell >= p->ne4 || value < 1 || value > p->ne2)return -1;
+  return session_move(p, MOVE_ASSIGN, cell, value);
+}
+
+EXPORT int32_t sd_session_eliminate(void *session, int32_t cell, int32_t value) {
+  session_t *p = session;
+  if(cell < 0 || cell >= p->ne4 || value < 1 || value > p->ne2)return -1;
+  return session_move(p, MOVE_ELIMINATE, cell, value);
+}
+
+EXPORT int32_t sd_session_undo(void *session) {
+  return session_undo(session);
+}
+
+EXPORT int32_t sd_session_redo(void *session) {
+  return session_redo(session);
+}
+
+EXPORT int32_t sd_session_conflict(void *session) {
+  return ((session_t *)session)->conflict;
+}
+
+EXPORT uint64_t *sd_session_candidates(void *session) {
+  return ((session_t *)session)->cand;
+}
+
+EXPORT uint8_t *sd_session_values(void *session) {
+  return ((session_t *)session)->values;
+}
+
+EXPORT void sd_session_free(void *session) {
+  if(session != NULL)free_session(session);
+}
+
 EXPORT int sd_solve(uint8_t *table, int32_t n) {
   sd_t *s = make_sd(n, table);
   RESULT res = solve_sd(s);
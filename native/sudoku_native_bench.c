@@ -0,0 +1,479 @@
+/*
+ * Solver benchmarks.
+ *
+ * Built from the same source as the FFI library:
+ *   cc -O3 -o sudoku_native_bench native/sudoku_native_bench.c -lm -lpthread
+ *
+ * Usage: sudoku_native_bench MODE [options] ...
+ */
+
+#include "sudoku_native.c"
+#include "sudoku_tools.h"
+
+static int cmp_sz(const void *a, const void *b) {
+  sz_t x = *(const sz_t *)a, y = *(const sz_t *)b;
+  return (x > y) - (x < y);
+}
+
+static int cmp_i64(const void *a, const void *b) {
+  int64_t x = *(const int64_t *)a, y = *(const int64_t *)b;
+  return (x > y) - (x < y);
+}
+
+static int64_t sd_now_us(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/* ============================================================================
+ * HEURISTICS
+ * ============================================================================ */
+
+static const char *heuristic_names[NO_HEURISTICS] = {"mrv", "mrv+fail", "dom/wdeg", "mrv+random"};
+
+/*
+ * Solve every puzzle of each corpus under every branching strategy and report
+ * search effort. Uniqueness is proven by exhausting the tree, so value
+ * ordering only changes effort when the column heuristic keeps state.
+ */
+static int bench_heuristics(int argc, char **argv) {
+  int32_t limit = 0;
+  int argi = 0;
+  if(argi + 1 < argc && !strcmp(argv[argi], "-l"))limit = atoi(argv[argi + 1]), argi += 2;
+  if(argi == argc) {
+    fprintf(stderr, "usage: heuristics [-l LIMIT] FILE...\n");
+    return 1;
+  }
+  printf("%-24s %-16s %7s %12s %9s %9s %10s %8s\n",
+         "corpus", "strategy", "solved", "forwards", "p50", "p99", "max", "seconds");
+  for(; argi < argc; ++argi) {
+    corpus_t corpus;
+    if(!load_corpus(argv[argi], &corpus))return 1;
+    if(limit > 0 && corpus.count > limit)corpus.count = limit;
+    const int32_t n = corpus.n;
+    const sz_t ne4 = n * n * n * n;
+    sz_t *forwards = malloc(sizeof(sz_t) * corpus.count);assert(forwards != NULL);
+    for(int32_t lcv = 0; lcv <= 1; ++lcv) {
+      for(int32_t h = 0; h < NO_HEURISTICS; ++h) {
+        const int32_t strategy = h | (lcv ? ORDER_LCV : 0);
+        int64_t total = 0;
+        sz_t solved = 0;
+        int64_t start = sd_now_ms();
+        for(sz_t i = 0; i < corpus.count; ++i) {
+          sd_t *s = make_sd(n, &corpus.tables[i * ne4]);
+          sd_set_strategy(s, strategy, (uint32_t)i + 1);
+          solved += solve_sd(s) == COMPLETE;
+          forwards[i] = s->forward_count, total += s->forward_count;
+          free_sd(s);
+        }
+        double elapsed = (sd_now_ms() - start) / 1000.0;
+        qsort(forwards, corpus.count, sizeof(sz_t), cmp_sz);
+        char name[32];
+        snprintf(name, sizeof(name), "%s%s", heuristic_names[h], lcv ? "+lcv" : "");
+        printf("%-24s %-16s %7ld %12lld %9ld %9ld %10ld %8.2f\n",
+               argv[argi], name, (long)solved, (long long)total,
+               (long)forwards[corpus.count / 2], (long)forwards[corpus.count * 99 / 100],
+               (long)forwards[corpus.count - 1], elapsed);
+        fflush(stdout);
+      }
+    }
+    free(forwards), free(corpus.tables);
+  }
+  return 0;
+}
+
+/* ============================================================================
+ * PORTFOLIO
+ * ============================================================================ */
+
+static void report_latency(const char *corpus, const char *name, int64_t *us, sz_t count) {
+  int64_t total = 0;
+  for(sz_t i = 0; i < count; ++i)total += us[i];
+  qsort(us, count, sizeof(int64_t), cmp_i64);
+  printf("%-24s %-16s %10.3f %10.3f %10.3f %10.3f\n", corpus, name,
+         total / 1000.0 / count, us[count / 2] / 1000.0, us[count * 99 / 100] / 1000.0, us[count - 1] / 1000.0);
+  fflush(stdout);
+}
+
+/*
+ * Per-puzzle latency of a plain solve against a portfolio of THREADS racing
+ * workers.
+ */
+static int bench_portfolio(int argc, char **argv) {
+  int32_t limit = 0, threads = 0;
+  int argi = 0;
+  for(; argi + 1 < argc && argv[argi][0] == '-'; argi += 2) {
+    if(!strcmp(argv[argi], "-l"))limit = atoi(argv[argi + 1]);
+    else if(!strcmp(argv[argi], "-j"))threads = atoi(argv[argi + 1]);
+  }
+  if(argi == argc) {
+    fprintf(stderr, "usage: portfolio [-j THREADS] [-l LIMIT] FILE...\n");
+    return 1;
+  }
+  printf("%-24s %-16s %10s %10s %10s %10s\n", "corpus", "solver", "mean ms", "p50 ms", "p99 ms", "max ms");
+  for(; argi < argc; ++argi) {
+    corpus_t corpus;
+    if(!load_corpus(argv[argi], &corpus))return 1;
+    if(limit > 0 && corpus.count > limit)corpus.count = limit;
+    const int32_t n = corpus.n;
+    const sz_t ne4 = n * n * n * n;
+    int64_t *us = malloc(sizeof(int64_t) * corpus.count);assert(us != NULL);
+    val_t *table = malloc(sizeof(val_t) * ne4);assert(table != NULL);
+    for(int portfolio = 0; portfolio <= 1; ++portfolio) {
+      for(sz_t i = 0; i < corpus.count; ++i) {
+        memcpy(table, &corpus.tables[i * ne4], sizeof(val_t) * ne4);
+        int64_t start = sd_now_us();
+        if(portfolio)solve_portfolio(table, n, threads, (uint32_t)i + 1, NULL);
+        else sd_solve(table, n);
+        us[i] = sd_now_us() - start;
+      }
+      report_latency(argv[argi], portfolio ? "portfolio" : "single", us, corpus.count);
+    }
+    free(us), free(table), free(corpus.tables);
+  }
+  return 0;
+}
+
+/* ============================================================================
+ * LEARNING
+ * ============================================================================ */
+
+/*
+ * Forwards and time of the default search against conflict learning on each
+ * puzzle, with the nogoods of the latter and its hits: rows struck out or
+ * failed by a nogood.
+ */
+static int bench_learning(int argc, char **argv) {
+  int32_t limit = 0;
+  int argi = 0;
+  if(argi + 1 < argc && !strcmp(argv[argi], "-l"))limit = atoi(argv[argi + 1]), argi += 2;
+  if(argi == argc) {
+    fprintf(stderr, "usage: learning [-l LIMIT] FILE...\n");
+    return 1;
+  }
+  printf("%-24s %6s %12s %9s %12s %9s %9s %9s\n", "corpus", "puzzle",
+         "forwards", "ms", "learn fwd", "learn ms", "nogoods", "hits");
+  for(; argi < argc; ++argi) {
+    corpus_t corpus;
+    if(!load_corpus(argv[argi], &corpus))return 1;
+    if(limit > 0 && corpus.count > limit)corpus.count = limit;
+    const int32_t n = corpus.n;
+    const sz_t ne4 = n * n * n * n;
+    int64_t total[2] = {0, 0}, total_us[2] = {0, 0};
+    for(sz_t i = 0; i < corpus.count; ++i) {
+      sz_t forwards[2];
+      int64_t us[2];
+      learn_t stats;
+      for(int learn = 0; learn <= 1; ++learn) {
+        sd_t *s = make_sd(n, &corpus.tables[i * ne4]);
+        if(learn)sd_set_strategy(s, DEFAULT_STRATEGY | SEARCH_LEARN, (uint32_t)i + 1);
+        int64_t start = sd_now_us();
+        solve_sd(s);
+        us[learn] = sd_now_us() - start;
+        forwards[learn] = s->forward_count;
+        total[learn] += forwards[learn], total_us[learn] += us[learn];
+        if(learn)stats = *s->learn;
+        free_sd(s);
+      }
+      printf("%-24s %6ld %12ld %9.2f %12ld %9.2f %9ld %9ld\n", argv[argi], (long)i,
+             (long)forwards[0], us[0] / 1000.0, (long)forwards[1], us[1] / 1000.0,
+             (long)stats.learned, (long)stats.hits);
+      fflush(stdout);
+    }
+    printf("%-24s %6s %12lld %9.2f %12lld %9.2f\n", argv[argi], "total",
+           (long long)total[0], total_us[0] / 1000.0, (long long)total[1], total_us[1] / 1000.0);
+    free(corpus.tables);
+  }
+  return 0;
+}
+
+/* ============================================================================
+ * SESSION
+ * ============================================================================ */
+
+#define SESSION_PHASES 5
+
+/*
+ * Play each puzzle to the end in a propagation session: every open cell in
+ * random order gets two wrong candidates eliminated and is then assigned its
+ * solution value, and every tenth move is undone and redone. Reports the mean
+ * latency of moves and undos per fifth of the game, and of rebuilding the
+ * session from the current board, which is what a full recompute costs.
+ */
+static int bench_session(int argc, char **argv) {
+  int32_t limit = 0;
+  int argi = 0;
+  if(argi + 1 < argc && !strcmp(argv[argi], "-l"))limit = atoi(argv[argi + 1]), argi += 2;
+  if(argi == argc) {
+    fprintf(stderr, "usage: session [-l LIMIT] FILE...\n");
+    return 1;
+  }
+  printf("%-24s %6s %9s %10s %10s %10s\n", "corpus", "phase", "moves", "move us", "undo us", "rebuild us");
+  for(; argi < argc; ++argi) {
+    corpus_t corpus;
+    if(!load_corpus(argv[argi], &corpus))return 1;
+    if(limit > 0 && corpus.count > limit)corpus.count = limit;
+    const int32_t n = corpus.n;
+    const sz_t ne2 = n * n, ne4 = ne2 * ne2;
+    val_t *solution = malloc(sizeof(val_t) * ne4), *board = malloc(sizeof(val_t) * ne4);
+    sz_t *order = malloc(sizeof(sz_t) * ne4);
+    assert(solution != NULL && board != NULL && order != NULL);
+    int64_t move_us[SESSION_PHASES] = {0}, undo_us[SESSION_PHASES] = {0}, rebuild_us[SESSION_PHASES] = {0};
+    sz_t moves[SESSION_PHASES] = {0}, undos[SESSION_PHASES] = {0}, rebuilds[SESSION_PHASES] = {0};
+    uint32_t rng = 1;
+    for(sz_t i = 0; i < corpus.count; ++i) {
+      const val_t *puzzle = &corpus.tables[i * ne4];
+      memcpy(solution, puzzle, sizeof(val_t) * ne4);
+      if(sd_solve(solution, n) != COMPLETE)continue;
+      session_t *p = make_session(puzzle, n);
+      if(p == NULL)continue;
+      memcpy(board, puzzle, sizeof(val_t) * ne4);
+      sz_t open = 0;
+      for(sz_t c = 0; c < ne4; ++c)if(!puzzle[c])order[open++] = c;
+      for(sz_t k = open - 1; k > 0; --k) {
+        sz_t j = xorshift32_r(&rng) % (k + 1), t = order[k];
+        order[k] = order[j], order[j] = t;
+      }
+      for(sz_t k = 0; k < open; ++k) {
+        const sz_t phase = k * SESSION_PHASES / open, c = order[k];
+        for(sz_t e = 0; e < 2; ++e) {
+          val_t v = 1 + xorshift32_r(&rng) % ne2;
+          if(v == solution[c])continue;
+          int64_t start = sd_now_us();
+          session_move(p, MOVE_ELIMINATE, c, v);
+          move_us[phase] += sd_now_us() - start, ++moves[phase];
+        }
+        int64_t start = sd_now_us();
+        session_move(p, MOVE_ASSIGN, c, solution[c]);
+        move_us[phase] += sd_now_us() - start, ++moves[phase];
+        board[c] = solution[c];
+        if(k % 10 == 9) {
+          start = sd_now_us();
+          session_undo(p);
+          undo_us[phase] += sd_now_us() - start, ++undos[phase];
+          session_redo(p);
+          start = sd_now_us();
+          free_session(make_session(board, n));
+          rebuild_us[phase] += sd_now_us() - start, ++rebuilds[phase];
+        }
+      }
+      free_session(p);
+    }
+    for(sz_t ph = 0; ph < SESSION_PHASES; ++ph) {
+      char name[16];
+      snprintf(name, sizeof(name), "%ld/%d", (long)ph + 1, SESSION_PHASES);
+      printf("%-24s %6s %9ld %10.2f %10.2f %10.2f\n", argv[argi], name, (long)moves[ph],
+             moves[ph] ? (double)move_us[ph] / moves[ph] : 0.0,
+             undos[ph] ? (double)undo_us[ph] / undos[ph] : 0.0,
+             rebuilds[ph] ? (double)rebuild_us[ph] / rebuilds[ph] : 0.0);
+    }
+    fflush(stdout);
+    free(solution), free(board), free(order), free(corpus.tables);
+  }
+  return 0;
+}
+
+/* ============================================================================
+ * GRIDS
+ * ============================================================================ */
+
+#define GRIDS_MAX_N 6
+
+// The former generate_puzzle start: random diagonal boxes completed by a full
+// solve, retried on an unsolvable fill. Returns the number of attempts.
+static int32_t diagonal_grid(val_t *out, sz_t n) {
+  sz_t ne2 = n * n, ne4 = ne2 * ne2;
+  sz_t *perm = malloc(sizeof(sz_t) * ne2);
+  for(int32_t attempt = 1;; ++attempt) {
+    memset(out, 0x00, sizeof(val_t) * ne4);
+    for(sz_t b = 0; b < n; ++b) {
+      ord_arr(perm, ne2),gen_shuffle_arr(perm, ne2);
+      for(sz_t j = 0; j < ne2; ++j)out[(b * n + j / n) * ne2 + b * n + j % n] = perm[j] + 1;
+    }
+    sd_t *s = make_sd(n, out);
+    RESULT res = solve_sd(s);
+    memcpy(out, s->table, sizeof(val_t) * ne4);
+    free_sd(s);
+    if(res != INVALID) {
+      free(perm);
+      return attempt;
+    }
+  }
+}
+
+/*
+ * Mean time to draw a solution grid for n=2..6 with sample_grid and with
+ * diagonal_grid. Sampled grids are checked by the solver outside the timing.
+ */
+static int bench_grids(int argc, char **argv) {
+  int32_t count = 200;
+  if(argc == 2 && !strcmp(argv[0], "-c"))count = atoi(argv[1]);
+  else if(argc != 0 || count < 1) {
+    fprintf(stderr, "usage: grids [-c COUNT]\n");
+    return 1;
+  }
+  printf("%4s %8s %12s %6s %12s %9s %9s\n", "n", "count", "sample us", "bad",
+         "diagonal us", "attempts", "speedup");
+  for(sz_t n = 2; n <= GRIDS_MAX_N; ++n) {
+    sz_t ne4 = n * n * n * n;
+    // diagonal fills for n=6 take tens of milliseconds each
+    int32_t runs = n < 5 ? count : n == 5 ? (count + 3) / 4 : (count + 15) / 16;
+    val_t *grid = malloc(sizeof(val_t) * ne4);
+    int64_t sample_us = 0, diagonal_us = 0, attempts = 0, bad = 0;
+    xorshift_state = 1;
+    for(int32_t i = 0; i < runs; ++i) {
+      int64_t start = sd_now_us();
+      sample_grid(grid, n);
+      sample_us += sd_now_us() - start;
+      sd_t *s = make_sd(n, grid);
+      bad += solve_sd(s) != COMPLETE;
+      free_sd(s);
+    }
+    xorshift_state = 1;
+    for(int32_t i = 0; i < runs; ++i) {
+      int64_t start = sd_now_us();
+      attempts += diagonal_grid(grid, n);
+      diagonal_us += sd_now_us() - start;
+    }
+    printf("%4ld %8ld %12.1f %6ld %12.1f %9.2f %8.1fx\n", (long)n, (long)runs,
+           (double)sample_us / runs, (long)bad, (double)diagonal_us / runs,
+           (double)attempts / runs, sample_us > 0 ? (double)diagonal_us / sample_us : 0.0);
+    fflush(stdout);
+    free(grid);
+  }
+  return 0;
+}
+
+/* ============================================================================
+ * BATCH
+ * ============================================================================ */
+
+/*
+ * Puzzles per second solving each corpus one puzzle at a time with solve_sd
+ * against solve_batch, with the number of boards the lanes handed back to
+ * solve_sd and of results or solutions that differ.
+ */
+static int bench_batch(int argc, char **argv) {
+  int32_t repeat = 1;
+  int argi = 0;
+  if(argi + 1 < argc && !strcmp(argv[argi], "-r"))repeat = atoi(argv[argi + 1]), argi += 2;
+  if(argi == argc || repeat < 1) {
+    fprintf(stderr, "usage: batch [-r REPEAT] FILE...\n");
+    return 1;
+  }
+  printf("%-24s %8s %12s %12s %8s %8s %9s\n", "corpus", "puzzles", "scalar/s", "batch/s",
+         "speedup", "dropped", "mismatch");
+  for(; argi < argc; ++argi) {
+    corpus_t corpus;
+    if(!load_corpus(argv[argi], &corpus))return 1;
+    const int32_t n = corpus.n;
+    const sz_t ne4 = n * n * n * n, count = corpus.count;
+    uint8_t *scalar = malloc(ne4 * count), *batch = malloc(ne4 * count);
+    uint8_t *scalar_res = malloc(count), *batch_res = malloc(count);
+    assert(scalar != NULL && batch != NULL && scalar_res != NULL && batch_res != NULL);
+    int64_t scalar_us = 0, batch_us = 0;
+    int32_t dropped = 0;
+    for(int32_t r = 0; r < repeat; ++r) {
+      memcpy(scalar, corpus.tables, ne4 * count), memcpy(batch, corpus.tables, ne4 * count);
+      int64_t start = sd_now_us();
+      for(sz_t i = 0; i < count; ++i) {
+        sd_t *s = make_sd(n, &scalar[i * ne4]);
+        scalar_res[i] = solve_sd(s);
+        if(scalar_res[i] == COMPLETE)memcpy(&scalar[i * ne4], s->table, ne4);
+        free_sd(s);
+      }
+      scalar_us += sd_now_us() - start;
+      start = sd_now_us();
+      solve_batch(batch, n, count, batch_res, &dropped);
+      batch_us += sd_now_us() - start;
+    }
+    sz_t mismatch = 0;
+    for(sz_t i = 0; i < count; ++i)
+      mismatch += scalar_res[i] != batch_res[i] || memcmp(&scalar[i * ne4], &batch[i * ne4], ne4);
+    double scalar_rate = scalar_us > 0 ? 1e6 * count * repeat / scalar_us : 0.0;
+    double batch_rate = batch_us > 0 ? 1e6 * count * repeat / batch_us : 0.0;
+    printf("%-24s %8ld %12.0f %12.0f %7.2fx %8d %9ld\n", argv[argi], (long)count, scalar_rate, batch_rate,
+           scalar_rate > 0 ? batch_rate / scalar_rate : 0.0, dropped, (long)mismatch);
+    free(scalar),free(batch),free(scalar_res),free(batch_res),free(corpus.tables);
+  }
+  return 0;
+}
+
+/*
+ * Cells per second checking each corpus and its solutions with validate_board
+ * one board at a time against validate_batch, which uses SIMD lanes for n <=
+ * VALIDATE_SIMD_MAX_N on x86, with the number of codes that differ.
+ */
+static int bench_validate(int argc, char **argv) {
+  int32_t repeat = 100;
+  int argi = 0;
+  if(argi + 1 < argc && !strcmp(argv[argi], "-r"))repeat = atoi(argv[argi + 1]), argi += 2;
+  if(argi == argc || repeat < 1) {
+    fprintf(stderr, "usage: validate [-r REPEAT] FILE...\n");
+    return 1;
+  }
+  printf("%-24s %8s %14s %14s %8s %9s\n", "corpus", "boards", "scalar cells/s", "simd cells/s",
+         "speedup", "mismatch");
+  for(; argi < argc; ++argi) {
+    corpus_t corpus;
+    if(!load_corpus(argv[argi], &corpus))return 1;
+    const int32_t n = corpus.n;
+    if(n > VALIDATE_MAX_N) {
+      fprintf(stderr, "%s: n=%d is above VALIDATE_MAX_N\n", argv[argi], n);
+      free(corpus.tables);
+      continue;
+    }
+    // the puzzles followed by their solutions, so every code path is timed
+    const sz_t ne4 = n * n * n * n, count = 2 * corpus.count;
+    uint8_t *boards = malloc(ne4 * count), *scalar_res = malloc(count), *simd_res = malloc(count);
+    assert(boards != NULL && scalar_res != NULL && simd_res != NULL);
+    memcpy(boards, corpus.tables, ne4 * corpus.count), memcpy(&boards[ne4 * corpus.count], corpus.tables, ne4 * corpus.count);
+    solve_batch(&boards[ne4 * corpus.count], n, corpus.count, simd_res, NULL);
+    int64_t scalar_us = 0, simd_us = 0;
+    for(int32_t r = 0; r < repeat; ++r) {
+      int64_t start = sd_now_us();
+      for(sz_t i = 0; i < count; ++i)scalar_res[i] = validate_board(&boards[i * ne4], n);
+      scalar_us += sd_now_us() - start;
+      start = sd_now_us();
+      validate_batch(boards, n, count, simd_res);
+      simd_us += sd_now_us() - start;
+    }
+    sz_t mismatch = 0;
+    for(sz_t i = 0; i < count; ++i)mismatch += scalar_res[i] != simd_res[i];
+    const double cells = (double)ne4 * count * repeat;
+    double scalar_rate = scalar_us > 0 ? 1e6 * cells / scalar_us : 0.0;
+    double simd_rate = simd_us > 0 ? 1e6 * cells / simd_us : 0.0;
+    printf("%-24s %8ld %14.3g %14.3g %7.2fx %9ld\n", argv[argi], (long)count, scalar_rate, simd_rate,
+           scalar_rate > 0 ? simd_rate / scalar_rate : 0.0, (long)mismatch);
+    free(boards),free(scalar_res),free(simd_res),free(corpus.tables);
+  }
+  return 0;
+}
+
+/* ============================================================================
+ * MAIN
+ * ============================================================================ */
+
+static const struct {
+  const char *name;
+  int (*run)(int argc, char **argv);
+  const char *help;
+} modes[] = {
+  {"heuristics", bench_heuristics, "[-l LIMIT] FILE...  every branching strategy over puzzle files"},
+  {"portfolio", bench_portfolio, "[-j THREADS] [-l LIMIT] FILE...  single vs portfolio solve latency"},
+  {"learning", bench_learning, "[-l LIMIT] FILE...  default search vs conflict learning per puzzle"},
+  {"session", bench_session, "[-l LIMIT] FILE...  propagation session latency over a game"},
+  {"batch", bench_batch, "[-r REPEAT] FILE...  solve_sd one by one vs lockstep solve_batch"},
+  {"validate", bench_validate, "[-r REPEAT] FILE...  scalar validate_board vs SIMD validate_batch"},
+  {"grids", bench_grids, "[-c COUNT]  solution grid sampler vs diagonal fill and solve, n=2..6"},
+};
+#define NO_MODES (sizeof(modes) / sizeof(modes[0]))
+
+int main(int argc, char **argv) {
+  for(size_t i = 0; argc > 1 && i < NO_MODES; ++i)
+    if(!strcmp(argv[1], modes[i].name))return modes[i].run(argc - 2, argv + 2);
+  fprintf(stderr, "usage: %s MODE ...\n", argv[0]);
+  for(size_t i = 0; i < NO_MODES; ++i)fprintf(stderr, "  %s %s\n", modes[i].name, modes[i].help);
+  return 1;
+}
@@ -0,0 +1,249 @@
+/*
+ * Bulk puzzle generator.
+ *
+ * Built from the same source as the FFI library:
+ *   cc -O3 -o sudoku_native_gen native/sudoku_native_gen.c -lm -lpthread
+ *
+ * Puzzle i of a run is generated from a seed derived from the base seed and i
+ * alone, and puzzles are written in index order, so the output depends only on
+ * the options and not on the number of threads or their scheduling.
+ */
+
+#include "sudoku_native.c"
+#include "sudoku_tools.h"
+
+#include <pthread.h>
+#include <unistd.h>
+#include <getopt.h>
+
+static void usage(const char *prog) {
+  fprintf(stderr,
+    "usage: %s [options]\n"
+    "  -n N        box size, 2..5 (default 3)\n"
+    "  -c COUNT    number of puzzles to write (default 1000)\n"
+    "  -d LO[:HI]  difficulty range in [0,1] (default 1)\n"
+    "  -s SEED     base seed (default 1)\n"
+    "  -j THREADS  worker threads (default: online cores)\n"
+    "  -r SAMPLES  rate each puzzle over SAMPLES isomorphs\n"
+    "  -u          drop puzzles whose canonical hash was already written\n"
+    "  -t MS       per-puzzle timeout, 0 = none (breaks reproducibility)\n"
+    "  -m          with -t, spend the second half of the timeout on minimality checks\n"
+    "  -b          binary output instead of lines\n"
+    "  -o FILE     output file (default stdout)\n",
+    prog);
+}
+
+/* ============================================================================
+ * OUTPUT
+ * ============================================================================ */
+
+/*
+ * Text: one puzzle per line in the assets/top1465 format, followed by
+ * tab-separated min/avg/max forwards when rating.
+ *
+ * Binary: 8-byte header "SDGN", version, n, flags (bit 0 = rated), 0; then per
+ * puzzle n^4 value bytes, followed when rated by min/avg/max forwards as
+ * little-endian int32.
+ */
+#define GEN_BIN_VERSION 1
+#define GEN_BIN_RATED 0x01
+
+static void put_le32(uint8_t *p, int32_t v) {
+  uint32_t u = (uint32_t)v;
+  p[0]=u&0xff,p[1]=(u>>8)&0xff,p[2]=(u>>16)&0xff,p[3]=(u>>24)&0xff;
+}
+
+/* ============================================================================
+ * DUPLICATE SET
+ * ============================================================================ */
+
+typedef struct {
+  uint64_t *keys;
+  size_t cap, len;
+} hashset_t;
+
+// Returns false if the key was already present.
+static bool hashset_insert(hashset_t *hs, uint64_t key) {
+  if(!key)key = 1;
+  if(2 * (hs->len + 1) > hs->cap) {
+    size_t oldcap = hs->cap;
+    uint64_t *old = hs->keys;
+    hs->cap = oldcap ? oldcap * 2 : 1024;
+    hs->keys = calloc(hs->cap, sizeof(uint64_t)),assert(hs->keys != NULL);
+    hs->len = 0;
+    for(size_t i = 0; i < oldcap; ++i)if(old[i])hashset_insert(hs, old[i]);
+    free(old);
+  }
+  size_t i = key & (hs->cap - 1);
+  while(hs->keys[i]) {
+    if(hs->keys[i] == key)return false;
+    i = (i + 1) & (hs->cap - 1);
+  }
+  hs->keys[i] = key, ++hs->len;
+  return true;
+}
+
+/* ============================================================================
+ * WORKERS
+ * ============================================================================ */
+
+typedef struct {
+  bool ready, ok;
+  val_t *table;
+  uint64_t hash;
+  difficulty_stats_t stats;
+} slot_t;
+
+typedef struct {
+  // options
+  int32_t n, count, rate_samples, timeout_ms, gen_flags;
+  float dmin, dmax;
+  uint64_t seed;
+  bool dedupe, binary;
+  FILE *out;
+  // shared state, guarded by mtx
+  pthread_mutex_t mtx;
+  pthread_cond_t cond;
+  int64_t next_index, next_emit;
+  int32_t written, dropped;
+  bool done;
+  sz_t window;
+  slot_t *slots;
+  hashset_t seen;
+  uint8_t *record;
+} gen_ctx_t;
+
+static void generate_slot(gen_ctx_t *g, int64_t index, slot_t *slot) {
+  uint64_t h = splitmix64(g->seed ^ splitmix64((uint64_t)index));
+  uint32_t seed = (uint32_t)h | 1;
+  float u = (float)(h >> 40) / (float)(1 << 24);
+  float difficulty = g->dmin + (g->dmax - g->dmin) * u;
+  int32_t hints = generate_puzzle(slot->table, g->n, seed, difficulty, g->timeout_ms, g->gen_flags, 1);
+  slot->ok = hints > 0;
+  if(slot->ok && g->rate_samples > 0)
+    slot->ok = estimate_difficulty(slot->table, g->n, g->rate_samples, seed, &slot->stats);
+  // hashed here rather than in emit_slot, which runs under the lock
+  if(slot->ok && g->dedupe)slot->hash = canonical_hash(slot->table, g->n);
+}
+
+static void emit_slot(gen_ctx_t *g, slot_t *slot) {
+  sz_t ne4 = g->n * g->n * g->n * g->n;
+  if(!slot->ok || (g->dedupe && !hashset_insert(&g->seen, slot->hash))) {
+    // give up when duplicates dominate, e.g. asking for more 4x4 puzzles than exist
+    if(++g->dropped > 10 * (int64_t)g->count + 1000)g->done = true;
+    return;
+  }
+  bool rated = g->rate_samples > 0;
+  if(g->binary) {
+    memcpy(g->record, slot->table, ne4);
+    if(rated)
+      put_le32(&g->record[ne4], slot->stats.min_forwards),
+      put_le32(&g->record[ne4 + 4], slot->stats.avg_forwards),
+      put_le32(&g->record[ne4 + 8], slot->stats.max_forwards);
+    fwrite(g->record, 1, ne4 + (rated ? 12 : 0), g->out);
+  } else {
+    for(sz_t i = 0; i < ne4; ++i)g->record[i] = sd_value_char(slot->table[i]);
+    fwrite(g->record, 1, ne4, g->out);
+    if(rated)
+      fprintf(g->out, "\t%d\t%d\t%d", slot->stats.min_forwards,
+              slot->stats.avg_forwards, slot->stats.max_forwards);
+    fputc('\n', g->out);
+  }
+  if(++g->written == g->count)g->done = true;
+}
+
+static void *gen_worker(void *arg) {
+  gen_ctx_t *g = arg;
+  pthread_mutex_lock(&g->mtx);
+  while(!g->done) {
+    // keep at most `window` puzzles in flight ahead of the writer
+    if(g->next_index >= g->next_emit + g->window) {
+      pthread_cond_wait(&g->cond, &g->mtx);
+      continue;
+    }
+    int64_t index = g->next_index++;
+    slot_t *slot = &g->slots[index % g->window];
+    pthread_mutex_unlock(&g->mtx);
+    generate_slot(g, index, slot);
+    pthread_mutex_lock(&g->mtx);
+    slot->ready = true;
+    while(!g->done) {
+      slot_t *head = &g->slots[g->next_emit % g->window];
+      if(!head->ready)break;
+      emit_slot(g, head);
+      head->ready = false, ++g->next_emit;
+    }
+    pthread_cond_broadcast(&g->cond);
+  }
+  pthread_mutex_unlock(&g->mtx);
+  return NULL;
+}
+
+/* ============================================================================
+ * MAIN
+ * ============================================================================ */
+
+int main(int argc, char **argv) {
+  gen_ctx_t g = {.n=3, .count=1000, .rate_samples=0, .timeout_ms=0, .gen_flags=0,
+    .dmin=1.0f, .dmax=1.0f, .seed=1, .dedupe=false, .binary=false, .out=stdout};
+  long nthreads = sysconf(_SC_NPROCESSORS_ONLN);
+  const char *outpath = NULL;
+  int opt;
+  while((opt = getopt(argc, argv, "n:c:d:s:j:r:t:mubo:h")) != -1) {
+    switch(opt) {
+      case 'n': g.n = atoi(optarg); break;
+      case 'c': g.count = atoi(optarg); break;
+      case 'd': {
+        char *end;
+        g.dmin = g.dmax = strtof(optarg, &end);
+        if(*end == ':')g.dmax = strtof(end + 1, NULL);
+      } break;
+      case 's': g.seed = strtoull(optarg, NULL, 0); break;
+      case 'j': nthreads = atol(optarg); break;
+      case 'r': g.rate_samples = atoi(optarg); break;
+      case 't': g.timeout_ms = atoi(optarg); break;
+      case 'm': g.gen_flags |= SD_GENERATE_MINIMAL; break;
+      case 'u': g.dedupe = true; break;
+      case 'b': g.binary = true; break;
+      case 'o': outpath = optarg; break;
+      default: usage(argv[0]); return opt == 'h' ? 0 : 1;
+    }
+  }
+  if(g.n < 2 || g.n > 5 || g.count < 1 || g.dmin < 0 || g.dmax > 1 || g.dmin > g.dmax) {
+    usage(argv[0]);
+    return 1;
+  }
+  if(nthreads < 1)nthreads = 1;
+  if(outpath && !(g.out = fopen(outpath, g.binary ? "wb" : "w"))) {
+    fprintf(stderr, "%s: %s\n", outpath, strerror(errno));
+    return 1;
+  }
+
+  sz_t ne4 = g.n * g.n * g.n * g.n;
+  pthread_mutex_init(&g.mtx, NULL), pthread_cond_init(&g.cond, NULL);
+  g.window = 4 * nthreads;
+  g.slots = calloc(g.window, sizeof(slot_t)),assert(g.slots != NULL);
+  for(sz_t i = 0; i < g.window; ++i)g.slots[i].table = malloc(ne4),assert(g.slots[i].table != NULL);
+  g.record = malloc(ne4 + 12),assert(g.record != NULL);
+  if(g.binary) {
+    const uint8_t header[8] = {'S', 'D', 'G', 'N', GEN_BIN_VERSION, (uint8_t)g.n,
+      g.rate_samples > 0 ? GEN_BIN_RATED : 0, 0};
+    fwrite(header, 1, sizeof(header), g.out);
+  }
+
+  int64_t start = sd_now_ms();
+  pthread_t *threads = malloc(sizeof(pthread_t) * nthreads);
+  for(long i = 0; i < nthreads; ++i)pthread_create(&threads[i], NULL, gen_worker, &g);
+  for(long i = 0; i < nthreads; ++i)pthread_join(threads[i], NULL);
+  double elapsed = (sd_now_ms() - start) / 1000.0;
+
+  fflush(g.out);
+  fprintf(stderr, "%d puzzles (%d dropped) in %.2fs on %ld threads: %.0f/s\n",
+          g.written, g.dropped, elapsed, nthreads,
+          elapsed > 0 ? g.written / elapsed : 0.0);
+  if(g.out != stdout)fclose(g.out);
+  for(sz_t i = 0; i < g.window; ++i)free(g.slots[i].table);
+  free(g.slots),free(g.record),free(g.seen.keys),free(threads);
+  pthread_mutex_destroy(&g.mtx), pthread_cond_destroy(&g.cond);
+  return 0;
+}
@@ -0,0 +1,418 @@
+/*
+ * Solver daemon: answers solve/rate/gen requests over a line protocol, so a
+ * caller pays for process start and table setup once instead of per request.
+ *
+ * Built from the same source as the FFI library:
+ *   cc -O3 -o sudoku_natived native/sudoku_natived.c -lm -lpthread
+ *
+ * Requests are read from stdin (replies on stdout) or, with -s, from every
+ * connection to a Unix domain socket. Each line is one request:
+ *
+ *   [ID] solve BOARD
+ *   [ID] rate BOARD [samples=N] [seed=S]
+ *   [ID] gen [n=N] [difficulty=D] [seed=S] [timeout=MS]
+ *
+ * Boards are written as by sudoku_native_gen, so n is at most 5. gen stops
+ * removing clues after DAEMON_GEN_TIMEOUT_MS unless timeout says otherwise
+ * (0 = no limit).
+ *
+ * and gets exactly one reply line starting with its ID (the line number on
+ * that connection when omitted):
+ *
+ *   ID ok SOLUTION | ID invalid | ID multiple
+ *   ID ok forwards=MIN/AVG/MAX backtracks=MIN/AVG/MAX samples=K
+ *   ID ok BOARD hints=H
+ *   ID error MESSAGE
+ *
+ * Requests run on a pool of worker threads, so a client may pipeline many of
+ * them and replies come back in completion order, not request order.
+ */
+
+#include "sudoku_native.c"
+#include "sudoku_tools.h"
+
+#include <pthread.h>
+#include <signal.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+static void usage(const char *prog) {
+  fprintf(stderr,
+    "usage: %s [options]\n"
+    "  -j THREADS  worker threads (default: online cores)\n"
+    "  -s PATH     listen on a Unix domain socket instead of stdin/stdout\n"
+    "  -q DEPTH    requests queued before readers block (default 64 per thread)\n",
+    prog);
+}
+
+#define DAEMON_MAX_ID 64
+// largest box size: boards are parsed with sd_line_n, which stops at 5
+#define DAEMON_MAX_N 5
+#define DAEMON_MAX_SAMPLES 1000
+#define DAEMON_MAX_ARGS 8
+#define DAEMON_GEN_TIMEOUT_MS 10000
+
+/* ============================================================================
+ * CONNECTIONS
+ * ============================================================================ */
+
+/*
+ * A connection is shared by its reader and every request still in flight; the
+ * last of them to let go closes it. Replies are written whole under wmtx so
+ * lines from different workers never interleave.
+ */
+typedef struct {
+  int rfd, wfd;
+  atomic_int refs;
+  pthread_mutex_t wmtx;
+} conn_t;
+
+static conn_t *make_conn(int rfd, int wfd) {
+  conn_t *c = malloc(sizeof(conn_t));assert(c != NULL);
+  c->rfd = rfd, c->wfd = wfd;
+  atomic_init(&c->refs, 1);
+  pthread_mutex_init(&c->wmtx, NULL);
+  return c;
+}
+
+static void conn_release(conn_t *c) {
+  if(atomic_fetch_sub(&c->refs, 1) != 1)return;
+  close(c->rfd);
+  if(c->wfd != c->rfd)close(c->wfd);
+  pthread_mutex_destroy(&c->wmtx);
+  free(c);
+}
+
+// A peer that hung up loses its replies; the request itself still completes.
+static void conn_write(conn_t *c, const char *buf, size_t len) {
+  pthread_mutex_lock(&c->wmtx);
+  while(len > 0) {
+    ssize_t k = write(c->wfd, buf, len);
+    if(k < 0 && errno == EINTR)continue;
+    if(k <= 0)break;
+    buf += k, len -= k;
+  }
+  pthread_mutex_unlock(&c->wmtx);
+}
+
+/* ============================================================================
+ * QUEUE
+ * ============================================================================ */
+
+typedef struct {
+  conn_t *conn;
+  int64_t line_no;
+  char *line;
+} job_t;
+
+typedef struct {
+  pthread_mutex_t mtx;
+  pthread_cond_t nonempty, nonfull;
+  job_t *jobs;
+  sz_t cap, head, len;
+  bool closed;
+} queue_t;
+
+static void queue_push(queue_t *q, job_t job) {
+  pthread_mutex_lock(&q->mtx);
+  while(q->len == q->cap)pthread_cond_wait(&q->nonfull, &q->mtx);
+  q->jobs[(q->head + q->len++) % q->cap] = job;
+  pthread_cond_signal(&q->nonempty);
+  pthread_mutex_unlock(&q->mtx);
+}
+
+// Returns false once the queue is closed and drained.
+static bool queue_pop(queue_t *q, job_t *job) {
+  pthread_mutex_lock(&q->mtx);
+  while(q->len == 0 && !q->closed)pthread_cond_wait(&q->nonempty, &q->mtx);
+  bool ok = q->len > 0;
+  if(ok)
+    *job = q->jobs[q->head], q->head = (q->head + 1) % q->cap, --q->len,
+    pthread_cond_signal(&q->nonfull);
+  pthread_mutex_unlock(&q->mtx);
+  return ok;
+}
+
+static void queue_close(queue_t *q) {
+  pthread_mutex_lock(&q->mtx);
+  q->closed = true;
+  pthread_cond_broadcast(&q->nonempty);
+  pthread_mutex_unlock(&q->mtx);
+}
+
+/* ============================================================================
+ * REQUESTS
+ * ============================================================================ */
+
+/*
+ * Each worker keeps one solver per box size, so a solve only resets the cover
+ * state of an existing sd_t instead of allocating one.
+ */
+typedef struct {
+  sd_t *solvers[DAEMON_MAX_N + 1];
+  val_t *table;
+  char *reply;
+} worker_t;
+
+// Per-process seed source for requests that do not pass seed=.
+static atomic_uint_fast64_t seed_counter;
+
+static uint32_t next_seed(void) {
+  return (uint32_t)splitmix64(atomic_fetch_add(&seed_counter, 1)) | 1;
+}
+
+// Parse "key=value" arguments; false on an unknown key or malformed value.
+static bool parse_option(const char *tok, const char *key, double lo, double hi, double *out) {
+  size_t k = strlen(key);
+  if(strncmp(tok, key, k) || tok[k] != '=')return false;
+  char *end;
+  double v = strtod(tok + k + 1, &end);
+  if(end == tok + k + 1 || *end || v < lo || v > hi)return false;
+  *out = v;
+  return true;
+}
+
+// Parse a board token into w->table; returns n, or 0 if it is not a board.
+static int32_t parse_board(worker_t *w, const char *tok) {
+  int32_t n = tok ? sd_line_n(strlen(tok)) : 0;
+  if(n && !sd_parse_line(tok, n, w->table))n = 0;
+  return n;
+}
+
+static void reply_board(char *p, const val_t *table, int32_t n) {
+  const sz_t ne4 = n * n * n * n;
+  for(sz_t i = 0; i < ne4; ++i)*p++ = sd_value_char(table[i]);
+  *p = '\0';
+}
+
+static const char *run_solve(worker_t *w, char **args, int nargs, char *out) {
+  int32_t n = nargs == 1 ? parse_board(w, args[0]) : 0;
+  if(!n)return "expected: solve BOARD";
+  if(w->solvers[n] == NULL)w->solvers[n] = make_sd(n, w->table);
+  sd_t *s = w->solvers[n];
+  memcpy(s->table, w->table, sizeof(val_t) * s->ne4);
+  RESULT res = solve_sd(s);
+  if(res == COMPLETE)strcpy(out, "ok "), reply_board(out + 3, s->table, n);
+  else strcpy(out, res == MULTIPLE ? "multiple" : "invalid");
+  return NULL;
+}
+
+static const char *run_rate(worker_t *w, char **args, int nargs, char *out) {
+  int32_t n = nargs >= 1 ? parse_board(w, args[0]) : 0;
+  if(!n)return "expected: rate BOARD [samples=N] [seed=S]";
+  double samples = 25, seed = 0;
+  for(int i = 1; i < nargs; ++i)
+    if(!parse_option(args[i], "samples", 1, DAEMON_MAX_SAMPLES, &samples)
+       && !parse_option(args[i], "seed", 0, UINT32_MAX, &seed))return "bad option";
+  difficulty_stats_t st;
+  if(!estimate_difficulty(w->table, n, (int32_t)samples, seed ? (uint32_t)seed : next_seed(), &st))
+    strcpy(out, "invalid");
+  else
+    sprintf(out, "ok forwards=%d/%d/%d backtracks=%d/%d/%d samples=%d",
+            st.min_forwards, st.avg_forwards, st.max_forwards,
+            st.min_backtracks, st.avg_backtracks, st.max_backtracks, st.samples);
+  return NULL;
+}
+
+static const char *run_gen(worker_t *w, char **args, int nargs, char *out) {
+  double n = 3, difficulty = 1, seed = 0, timeout = DAEMON_GEN_TIMEOUT_MS;
+  for(int i = 0; i < nargs; ++i)
+    if(!parse_option(args[i], "n", 2, DAEMON_MAX_N, &n)
+       && !parse_option(args[i], "difficulty", 0, 1, &difficulty)
+       && !parse_option(args[i], "seed", 0, UINT32_MAX, &seed)
+       && !parse_option(args[i], "timeout", 0, INT32_MAX, &timeout))return "bad option";
+  if(n != (int32_t)n)return "bad option";
+  int32_t hints = generate_puzzle(w->table, (int32_t)n, seed ? (uint32_t)seed : next_seed(),
+                                  (float)difficulty, (int32_t)timeout, 0, 1);
+  strcpy(out, "ok "), reply_board(out + 3, w->table, (int32_t)n);
+  sprintf(out + strlen(out), " hints=%d", hints);
+  return NULL;
+}
+
+static const struct {
+  const char *name;
+  const char *(*run)(worker_t *, char **, int, char *);
+} commands[] = {
+  {"solve", run_solve},
+  {"rate", run_rate},
+  {"gen", run_gen},
+};
+
+static int find_command(const char *name) {
+  for(int i = 0; i < (int)(sizeof(commands) / sizeof(commands[0])); ++i)
+    if(!strcmp(name, commands[i].name))return i;
+  return -1;
+}
+
+static void serve_job(worker_t *w, job_t *job) {
+  char *args[DAEMON_MAX_ARGS + 1], *save;
+  int nargs = 0;
+  for(char *tok = strtok_r(job->line, " \t", &save); tok && nargs <= DAEMON_MAX_ARGS; tok = strtok_r(NULL, " \t", &save))
+    args[nargs++] = tok;
+
+  // the first token is the request id unless it already names a command
+  int first = find_command(args[0]) < 0;
+  int cmd = first < nargs ? find_command(args[first]) : -1;
+  char id[DAEMON_MAX_ID + 1];
+  if(first)snprintf(id, sizeof(id), "%s", args[0]);
+  else snprintf(id, sizeof(id), "%lld", (long long)job->line_no);
+
+  size_t idlen = strlen(id);
+  char *out = w->reply + idlen + 1;
+  const char *err = cmd < 0 ? "unknown command"
+    : nargs > DAEMON_MAX_ARGS ? "too many arguments"
+    : commands[cmd].run(w, args + first + 1, nargs - first - 1, out);
+  if(err != NULL)sprintf(out, "error %s", err);
+  memcpy(w->reply, id, idlen), w->reply[idlen] = ' ';
+  size_t len = strlen(w->reply);
+  w->reply[len] = '\n';
+  conn_write(job->conn, w->reply, len + 1);
+}
+
+static void *daemon_worker(void *arg) {
+  queue_t *q = arg;
+  worker_t w = {.solvers={NULL}};
+  const sz_t max_ne4 = DAEMON_MAX_N * DAEMON_MAX_N * DAEMON_MAX_N * DAEMON_MAX_N;
+  // largest reply: id, "ok ", a DAEMON_MAX_N board and " hints=..."
+  w.table = malloc(max_ne4),assert(w.table != NULL);
+  w.reply = malloc(DAEMON_MAX_ID + max_ne4 + 128),assert(w.reply != NULL);
+  job_t job;
+  while(queue_pop(q, &job)) {
+    serve_job(&w, &job);
+    free(job.line);
+    conn_release(job.conn);
+  }
+  for(sz_t n = 0; n <= DAEMON_MAX_N; ++n)if(w.solvers[n])free_sd(w.solvers[n]);
+  free(w.table),free(w.reply);
+  return NULL;
+}
+
+/* ============================================================================
+ * READERS
+ * ============================================================================ */
+
+typedef struct {
+  queue_t *q;
+  conn_t *conn;
+} reader_t;
+
+static void read_requests(queue_t *q, conn_t *c) {
+  FILE *fp = fdopen(dup(c->rfd), "r");assert(fp != NULL);
+  char *line = NULL;
+  size_t cap = 0;
+  ssize_t len;
+  int64_t line_no = 0;
+  while((len = getline(&line, &cap, fp)) >= 0) {
+    ++line_no;
+    line[strcspn(line, "\r\n")] = '\0';
+    if(!line[strspn(line, " \t")])continue;
+    atomic_fetch_add(&c->refs, 1);
+    queue_push(q, (job_t){.conn=c, .line_no=line_no, .line=strdup(line)});
+  }
+  free(line);
+  fclose(fp);
+}
+
+static void *socket_reader(void *arg) {
+  reader_t r = *(reader_t *)arg;
+  free(arg);
+  read_requests(r.q, r.conn);
+  conn_release(r.conn);
+  return NULL;
+}
+
+static const char *socket_path;
+
+static void on_signal(int sig) {
+  if(socket_path)unlink(socket_path);
+  signal(sig, SIG_DFL), raise(sig);
+}
+
+static int listen_socket(const char *path) {
+  struct sockaddr_un addr = {.sun_family=AF_UNIX};
+  if(strlen(path) >= sizeof(addr.sun_path)) {
+    fprintf(stderr, "%s: socket path too long\n", path);
+    return -1;
+  }
+  strcpy(addr.sun_path, path);
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  unlink(path);
+  if(fd < 0 || bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(fd, 64) < 0) {
+    fprintf(stderr, "%s: %s\n", path, strerror(errno));
+    if(fd >= 0)close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+/* ============================================================================
+ * MAIN
+ * ============================================================================ */
+
+int main(int argc, char **argv) {
+  long nthreads = sysconf(_SC_NPROCESSORS_ONLN), depth = 0;
+  int opt;
+  while((opt = getopt(argc, argv, "j:s:q:h")) != -1) {
+    switch(opt) {
+      case 'j': nthreads = atol(optarg); break;
+      case 's': socket_path = optarg; break;
+      case 'q': depth = atol(optarg); break;
+      default: usage(argv[0]); return opt == 'h' ? 0 : 1;
+    }
+  }
+  if(optind < argc) {
+    usage(argv[0]);
+    return 1;
+  }
+  if(nthreads < 1)nthreads = 1;
+  if(depth < 1)depth = 64 * nthreads;
+
+  signal(SIGPIPE, SIG_IGN);
+  warmup(SD_WARMUP_TOPOLOGY);
+  atomic_init(&seed_counter, (uint64_t)time(NULL) << 20);
+
+  queue_t q = {.cap=depth, .head=0, .len=0, .closed=false};
+  pthread_mutex_init(&q.mtx, NULL);
+  pthread_cond_init(&q.nonempty, NULL), pthread_cond_init(&q.nonfull, NULL);
+  q.jobs = malloc(sizeof(job_t) * q.cap),assert(q.jobs != NULL);
+  pthread_t *threads = malloc(sizeof(pthread_t) * nthreads);
+  for(long i = 0; i < nthreads; ++i)pthread_create(&threads[i], NULL, daemon_worker, &q);
+
+  int status = 0;
+  if(socket_path == NULL) {
+    // stdin/stdout: exit once every request read before EOF has been answered
+    conn_t *c = make_conn(dup(STDIN_FILENO), dup(STDOUT_FILENO));
+    read_requests(&q, c);
+    conn_release(c);
+  } else {
+    int lfd = listen_socket(socket_path);
+    if(lfd < 0)status = 1;
+    else {
+      signal(SIGINT, on_signal), signal(SIGTERM, on_signal);
+      for(;;) {
+        int fd = accept(lfd, NULL, NULL);
+        if(fd < 0) {
+          if(errno == EINTR || errno == ECONNABORTED)continue;
+          fprintf(stderr, "%s: %s\n", socket_path, strerror(errno));
+          status = 1;
+          break;
+        }
+        reader_t *r = malloc(sizeof(reader_t));assert(r != NULL);
+        r->q = &q, r->conn = make_conn(fd, fd);
+        pthread_t t;
+        if(pthread_create(&t, NULL, socket_reader, r))conn_release(r->conn),free(r);
+        else pthread_detach(t);
+      }
+      close(lfd), unlink(socket_path);
+    }
+  }
+
+  queue_close(&q);
+  for(long i = 0; i < nthreads; ++i)pthread_join(threads[i], NULL);
+  free(q.jobs),free(threads);
+  pthread_mutex_destroy(&q.mtx);
+  pthread_cond_destroy(&q.nonempty), pthread_cond_destroy(&q.nonfull);
+  return status;
+}
@@ -0,0 +1,96 @@
+/*
+ * Helpers shared by the command-line tools. Include after sudoku_native.c.
+ */
+
+#ifndef SUDOKU_TOOLS_H
+#define SUDOKU_TOOLS_H
+
+#include <errno.h>
+
+/* ============================================================================
+ * LINE FORMAT
+ * ============================================================================ */
+
+// Puzzles are written one per line as in assets/top1465: '.' (or '0') for an
+// empty cell, 1-9, then A-Z for values from 10 up.
+static inline char sd_value_char(val_t v) {
+  if(!v)return '.';
+  return v <= 9 ? '0' + v : 'A' + v - 10;
+}
+
+// Returns -1 for characters that are not cell values.
+static inline int sd_char_value(char ch) {
+  if(ch == '.' || ch == '0')return 0;
+  if(ch >= '1' && ch <= '9')return ch - '0';
+  if(ch >= 'A' && ch <= 'Z')return ch - 'A' + 10;
+  if(ch >= 'a' && ch <= 'z')return ch - 'a' + 10;
+  return -1;
+}
+
+// Box size for a line of len cells, or 0 if len is not n^4 for 2 <= n <= 5.
+// The alphabet ends at Z = 35, so 36x36 boards cannot be written.
+static inline int32_t sd_line_n(size_t len) {
+  for(int32_t n = 2; n <= 5; ++n)if((size_t)(n * n * n * n) == len)return n;
+  return 0;
+}
+
+// Parse ne4 cells; false if a character is not a value in 0..ne2.
+static inline bool sd_parse_line(const char *line, int32_t n, val_t *table) {
+  const sz_t ne2 = n * n, ne4 = ne2 * ne2;
+  for(sz_t i = 0; i < ne4; ++i) {
+    int v = sd_char_value(line[i]);
+    if(v < 0 || v > ne2)return false;
+    table[i] = v;
+  }
+  return true;
+}
+
+/* ============================================================================
+ * CORPORA
+ * ============================================================================ */
+
+typedef struct {
+  int32_t n;
+  sz_t count;
+  val_t *tables;
+} corpus_t;
+
+/*
+ * Load every puzzle of a line-format file. The box size comes from the first
+ * puzzle line; lines of other lengths are skipped.
+ */
+static inline bool load_corpus(const char *path, corpus_t *c) {
+  FILE *fp = fopen(path, "r");
+  if(fp == NULL) {
+    fprintf(stderr, "%s: %s\n", path, strerror(errno));
+    return false;
+  }
+  *c = (corpus_t){.n=0, .count=0, .tables=NULL};
+  sz_t cap = 0;
+  char line[4096];
+  while(fgets(line, sizeof(line), fp)) {
+    size_t len = strcspn(line, "\r\n");
+    if(!c->n && !(c->n = sd_line_n(len)))continue;
+    const sz_t ne4 = c->n * c->n * c->n * c->n;
+    if(len != (size_t)ne4)continue;
+    if(c->count == cap)
+      cap = cap ? cap * 2 : 256,
+      c->tables = realloc(c->tables, sizeof(val_t) * ne4 * cap),assert(c->tables != NULL);
+    if(sd_parse_line(line, c->n, &c->tables[c->count * ne4]))++c->count;
+  }
+  fclose(fp);
+  return c->count > 0;
+}
+
+/* ============================================================================
+ * SEEDS
+ * ============================================================================ */
+
+static inline uint64_t splitmix64(uint64_t x) {
+  x += 0x9e3779b97f4a7c15ULL;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  return x ^ (x >> 31);
+}
+
+#endif